@@ -0,0 +1,106 @@
+// fms_aggregate.h - Portfolio totals maintained as trades are inserted and removed.
+// Totals are updated by each trade's contribution while the curve version is fixed
+// and recomputed from scratch when the curve version changes.
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <gsl/gsl>
+#include "fms_curve.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class aggregate {
+        struct trade {
+            std::vector<T> u;
+            std::vector<F> c;
+        };
+        curve<T, F> c;
+        uint64_t version_;
+        std::unordered_map<size_t, trade> trades;
+        F pv, dur;
+        std::vector<F> kr, d; // key rates and scratch
+
+        // add sign times the contribution of trade x to the totals
+        void add(const trade& x, F sign)
+        {
+            auto v = c.view();
+            for (size_t i = 0; i < x.u.size(); ++i) {
+                F cD = sign * x.c[i] * v.discount(x.u[i]);
+                pv += cD;
+                dur -= x.u[i] * cD;
+            }
+            pwflat::key_rate(x.u.size(), x.u.data(), x.c.data(), v.n, v.t, v.f, v.I, d.data(), v._f);
+            for (size_t j = 0; j < kr.size(); ++j)
+                kr[j] += sign * d[j];
+        }
+        void revalue()
+        {
+            pv = 0;
+            dur = 0;
+            kr.assign(c.size() + 1, F(0));
+            d.resize(c.size() + 1);
+            for (const auto& x : trades)
+                add(x.second, 1);
+        }
+    public:
+        aggregate(curve<T, F> c_, uint64_t version = 0)
+            : c(std::move(c_)), version_(version)
+        {
+            revalue();
+        }
+
+        uint64_t version() const noexcept
+        {
+            return version_;
+        }
+        // number of trades
+        size_t size() const noexcept
+        {
+            return trades.size();
+        }
+        F present_value() const noexcept
+        {
+            return pv;
+        }
+        F duration() const noexcept
+        {
+            return dur;
+        }
+        // derivatives wrt f[j], j < n, and _f
+        const F* key_rate() const noexcept
+        {
+            return kr.data();
+        }
+
+        // Add trade id with cash flows c_[i] at times u_[i].
+        void insert(size_t id, size_t m, const T* u_, const F* c_)
+        {
+            auto [x, ins] = trades.emplace(id, trade{ std::vector<T>(u_, u_ + m), std::vector<F>(c_, c_ + m) });
+            Expects(ins);
+            add(x->second, 1);
+        }
+        // Remove trade id.
+        void remove(size_t id)
+        {
+            auto x = trades.find(id);
+            Expects(x != trades.end());
+            add(x->second, -1);
+            trades.erase(x);
+        }
+
+        // Revalue all trades if the curve version changed.
+        void update(curve<T, F> c_, uint64_t version)
+        {
+            if (version == version_)
+                return;
+
+            c = std::move(c_);
+            version_ = version;
+            revalue();
+        }
+    };
+
+} // fms::pwflat
@@ -0,0 +1,128 @@
+// fms_bump.h - Shifted, bumped, twisted and rolled views of a curve.
+// Each adaptor adds a closed form change to the value and integral of a base view,
+// so no forwards are copied and the base cumulative integrals are reused.
+#pragma once
+#include <cmath>
+#include <limits>
+#include "fms_curve.h"
+
+namespace fms::pwflat {
+
+    // sum of c[i] D(u[i]) for any curve with a discount member
+    template<class V, class T, class F>
+    inline F present_value(const V& v, size_t m, const T* u, const F* c) noexcept
+    {
+        F p{ 0 };
+
+        for (size_t i = 0; i < m; ++i)
+            p += c[i] * v.discount(u[i]);
+
+        return p;
+    }
+
+    // forward f(t) + a
+    template<class T = double, class F = double>
+    struct shifted {
+        view<T, F> v;
+        F a;
+
+        F value(const T& u) const noexcept
+        {
+            return v.value(u) + a;
+        }
+        F integral(const T& u) const noexcept
+        {
+            return v.integral(u) + a * u;
+        }
+        F discount(const T& u) const noexcept
+        {
+            return exp(-integral(u));
+        }
+        F present_value(size_t m, const T* u, const F* c) const noexcept
+        {
+            return pwflat::present_value(*this, m, u, c);
+        }
+    };
+
+    // forward f[j] + a on (t[j-1], t[j]], or _f + a past t[n-1] if j = n
+    template<class T = double, class F = double>
+    struct bumped {
+        view<T, F> v;
+        size_t j;
+        F a;
+
+        F value(const T& u) const noexcept
+        {
+            bool in = (j == 0 || v.t[j - 1] < u) && (j == v.n || u <= v.t[j]);
+
+            return v.value(u) + (in ? a : 0);
+        }
+        F integral(const T& u) const noexcept
+        {
+            return v.integral(u) + a * overlap(j, u, v.n, v.t);
+        }
+        F discount(const T& u) const noexcept
+        {
+            return exp(-integral(u));
+        }
+        F present_value(size_t m, const T* u, const F* c) const noexcept
+        {
+            return pwflat::present_value(*this, m, u, c);
+        }
+    };
+
+    // forward f(t) + a + b (t - p) rotating about the pivot p
+    template<class T = double, class F = double>
+    struct twisted {
+        view<T, F> v;
+        F a, b;
+        T p;
+
+        F value(const T& u) const noexcept
+        {
+            return v.value(u) + a + b * (u - p);
+        }
+        F integral(const T& u) const noexcept
+        {
+            return v.integral(u) + (a - b * p) * u + b * u * u / 2;
+        }
+        F discount(const T& u) const noexcept
+        {
+            return exp(-integral(u));
+        }
+        F present_value(size_t m, const T* u, const F* c) const noexcept
+        {
+            return pwflat::present_value(*this, m, u, c);
+        }
+    };
+
+    // curve seen from time s with D_s(u) = D(s + u)/D(s)
+    template<class T = double, class F = double>
+    struct rolled {
+        view<T, F> v;
+        T s;
+        F Is; // int_0^s f(t) dt
+
+        rolled(const view<T, F>& v_, const T& s_) noexcept
+            : v(v_), s(s_), Is(v_.integral(s_))
+        { }
+
+        F value(const T& u) const noexcept
+        {
+            return u < 0 ? std::numeric_limits<F>::quiet_NaN() : v.value(s + u);
+        }
+        F integral(const T& u) const noexcept
+        {
+            return u < 0 ? std::numeric_limits<F>::quiet_NaN() : v.integral(s + u) - Is;
+        }
+        F discount(const T& u) const noexcept
+        {
+            return exp(-integral(u));
+        }
+        F present_value(size_t m, const T* u, const F* c) const noexcept
+        {
+            return pwflat::present_value(*this, m, u, c);
+        }
+    };
+
+} // fms::pwflat
@@ -0,0 +1,106 @@
+// fms_composite.h - Sum of piecewise flat curves, e.g. a base curve plus a spread.
+// Values are summed directly. The merged knots and cumulative integrals of the sum
+// are built on the first call that needs them in one pass over all knots.
+#pragma once
+#include <initializer_list>
+#include <limits>
+#include <mutex>
+#include <vector>
+#include "fms_curve.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class composite {
+        std::vector<pwflat::view<T, F>> v_;
+        mutable std::once_flag once;
+        mutable curve<T, F> sum;
+
+        void merge() const
+        {
+            constexpr T inf = std::numeric_limits<T>::infinity();
+            std::vector<size_t> j(v_.size(), 0);
+            std::vector<T> t;
+            std::vector<F> f;
+            F _f{ 0 };
+
+            for (const auto& v : v_)
+                _f += v._f;
+            while (true) {
+                T t_ = inf;
+                for (size_t k = 0; k < v_.size(); ++k) {
+                    if (j[k] < v_[k].n && v_[k].t[j[k]] < t_)
+                        t_ = v_[k].t[j[k]];
+                }
+                if (t_ == inf)
+                    break;
+
+                // forward on (t[i-1], t_]
+                F f_{ 0 };
+                for (size_t k = 0; k < v_.size(); ++k) {
+                    if (j[k] < v_[k].n) {
+                        f_ += v_[k].f[j[k]];
+                        if (v_[k].t[j[k]] == t_)
+                            ++j[k];
+                    }
+                    else {
+                        f_ += v_[k]._f;
+                    }
+                }
+                t.push_back(t_);
+                f.push_back(f_);
+            }
+
+            sum = curve<T, F>(t.size(), t.data(), f.data(), _f);
+        }
+    public:
+        // Curves must outlive the composite.
+        composite(std::initializer_list<pwflat::view<T, F>> v)
+            : v_(v)
+        { }
+        composite(size_t k, const pwflat::view<T, F>* v)
+            : v_(v, v + k)
+        { }
+
+        // number of curves in the sum
+        size_t curves() const noexcept
+        {
+            return v_.size();
+        }
+
+        // the merged curve
+        const curve<T, F>& merged() const
+        {
+            std::call_once(once, [this] { merge(); });
+
+            return sum;
+        }
+        pwflat::view<T, F> view() const
+        {
+            return merged().view();
+        }
+
+        F value(const T& u) const noexcept
+        {
+            F v{ 0 };
+
+            for (const auto& c : v_)
+                v += c.value(u);
+
+            return v;
+        }
+        F integral(const T& u) const
+        {
+            return merged().integral(u);
+        }
+        F discount(const T& u) const
+        {
+            return merged().discount(u);
+        }
+        F present_value(size_t m, const T* u, const F* c) const
+        {
+            return merged().present_value(m, u, c);
+        }
+    };
+
+} // fms::pwflat
@@ -0,0 +1,60 @@
+// fms_credit.h - Risky annuity and protection leg integrals.
+// On a segment where both the forward rate r and the hazard rate h are flat
+// int_a^b D(t) S(t) dt = D(a) S(a) (1 - exp(-(r + h)(b - a)))/(r + h),
+// so merging the knots of the two curves gives the integrals exactly.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "fms_pwflat.h"
+
+namespace fms::pwflat {
+
+    // Protection P[q] = int_0^u[q] h(t) D(t) S(t) dt and annuity A[q] = int_0^u[q] D(t) S(t) dt
+    // for increasing u[q] >= 0 where D has forwards (n, t, f, _f) and the survival
+    // S has hazard rates (k, s, h, _h). P or A may be null.
+    template<class T, class F>
+    inline void legs(size_t m, const T* u, identity_t<F>* P, identity_t<F>* A,
+        size_t n, const T* t, const F* f, const F& _f,
+        size_t k, const T* s, const F* h, const F& _h) noexcept
+    {
+        constexpr T inf = std::numeric_limits<T>::infinity();
+        T a{ 0 };
+        F DS{ 1 }, P_{ 0 }, A_{ 0 };
+        size_t i = 0, j = 0;
+
+        for (size_t q = 0; q < m; ++q) {
+            while (a < u[q]) {
+                T b = std::min(u[q], std::min(i < n ? t[i] : inf, j < k ? s[j] : inf));
+                F r = i < n ? f[i] : _f;
+                F l = j < k ? h[j] : _h;
+                F x = (r + l) * (b - a);
+                F I = x == 0 ? static_cast<F>(b - a) : -expm1(-x) / (r + l); // int_a^b exp(-(r + l)(t - a)) dt
+
+                A_ += DS * I;
+                P_ += l * DS * I;
+                DS *= exp(-x);
+
+                if (i < n && b == t[i])
+                    ++i;
+                if (j < k && b == s[j])
+                    ++j;
+                a = b;
+            }
+            if (P)
+                P[q] = P_;
+            if (A)
+                A[q] = A_;
+        }
+    }
+
+    // protection and annuity to maturity u
+    template<class T, class F>
+    inline void legs(const T& u, F& P, F& A,
+        size_t n, const T* t, const F* f, const F& _f,
+        size_t k, const T* s, const F* h, const F& _h) noexcept
+    {
+        legs(1, &u, &P, &A, n, t, f, _f, k, s, h, _h);
+    }
+
+} // fms::pwflat
@@ -0,0 +1,115 @@
+// fms_csr.h - Portfolio cash flows as a sparse instrument by date matrix.
+// Row k holds the cash flows of instrument k in compressed sparse row format
+// with columns indexing the distinct payment dates of the whole portfolio.
+// Portfolio present value is the product of the matrix with the date discounts.
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "fms_parallel.h"
+#include "fms_portfolio.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class csr {
+        std::vector<T> u;        // distinct dates
+        std::vector<size_t> row; // row k is [row[k], row[k+1])
+        std::vector<size_t> col;
+        std::vector<F> val;
+    public:
+        csr(const portfolio<T, F>& pf)
+            : row{ 0 }
+        {
+            for (size_t k = 0; k < pf.size(); ++k)
+                u.insert(u.end(), pf.time(k), pf.time(k) + pf.size(k));
+            std::sort(u.begin(), u.end());
+            u.erase(std::unique(u.begin(), u.end()), u.end());
+
+            row.reserve(pf.size() + 1);
+            col.reserve(pf.cash_flows());
+            val.reserve(pf.cash_flows());
+            for (size_t k = 0; k < pf.size(); ++k) {
+                for (size_t i = 0; i < pf.size(k); ++i) {
+                    size_t j = std::lower_bound(u.begin(), u.end(), pf.time(k)[i]) - u.begin();
+                    // cash flows at the same time in one instrument share an entry
+                    if (col.size() > row.back() && col.back() == j) {
+                        val.back() += pf.cash(k)[i];
+                    }
+                    else {
+                        col.push_back(j);
+                        val.push_back(pf.cash(k)[i]);
+                    }
+                }
+                row.push_back(col.size());
+            }
+        }
+
+        // number of instruments
+        size_t rows() const noexcept
+        {
+            return row.size() - 1;
+        }
+        // number of distinct dates
+        size_t cols() const noexcept
+        {
+            return u.size();
+        }
+        size_t nonzeros() const noexcept
+        {
+            return val.size();
+        }
+        // increasing distinct dates
+        const T* dates() const noexcept
+        {
+            return u.data();
+        }
+
+        // D[j] = D(dates()[j])
+        void discount(F* D, size_t n, const T* t, const F* f,
+            const F& _f = std::numeric_limits<F>::quiet_NaN()) const noexcept
+        {
+            discounts(cols(), dates(), D, n, t, f, _f);
+        }
+
+        // y = A x using p threads
+        void multiply(const F* x, F* y, size_t p = 0) const
+        {
+            size_t nb = std::min(threads(p) * 16, rows());
+            parallel_for(nb, [&](size_t b) {
+                for (size_t k = b * rows() / nb; k < (b + 1) * rows() / nb; ++k) {
+                    F yk{ 0 };
+                    for (size_t i = row[k]; i < row[k + 1]; ++i)
+                        yk += val[i] * x[col[i]];
+                    y[k] = yk;
+                }
+            }, p);
+        }
+
+        // Y = A X for cols() by s row-major X and rows() by s row-major Y using p threads
+        void multiply(size_t s, const F* X, F* Y, size_t p = 0) const
+        {
+            size_t nb = std::min(threads(p) * 16, rows());
+            parallel_for(nb, [&](size_t b) {
+                for (size_t k = b * rows() / nb; k < (b + 1) * rows() / nb; ++k) {
+                    F* Yk = Y + k * s;
+                    std::fill(Yk, Yk + s, F(0));
+                    for (size_t i = row[k]; i < row[k + 1]; ++i) {
+                        const F* Xj = X + col[i] * s;
+                        for (size_t l = 0; l < s; ++l)
+                            Yk[l] += val[i] * Xj[l];
+                    }
+                }
+            }, p);
+        }
+
+        // pv[k] = present value of instrument k using scratch D[cols()] and p threads
+        void present_value(F* pv, F* D, size_t n, const T* t, const F* f,
+            const F& _f = std::numeric_limits<F>::quiet_NaN(), size_t p = 0) const
+        {
+            discount(D, n, t, f, _f);
+            multiply(D, pv, p);
+        }
+    };
+
+} // fms::pwflat
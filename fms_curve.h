@@ -0,0 +1,99 @@
+// fms_curve.h - Piecewise flat curve owning its times and forwards.
+#pragma once
+#include <limits>
+#include <vector>
+#include "fms_pwflat.h"
+
+namespace fms::pwflat {
+
+    // non-owning curve with cumulative integrals I[i] = int_0^t[i] f(t) dt
+    template<class T = double, class F = double>
+    struct view {
+        size_t n;
+        const T* t;
+        const F* f;
+        const F* I;
+        F _f;
+
+        F value(const T& u) const noexcept
+        {
+            return pwflat::value(u, n, t, f, _f);
+        }
+        F integral(const T& u) const noexcept
+        {
+            return pwflat::integral(u, n, t, f, I, _f);
+        }
+        F discount(const T& u) const noexcept
+        {
+            return pwflat::discount(u, n, t, f, I, _f);
+        }
+        F present_value(size_t m, const T* u, const F* c) const noexcept
+        {
+            F p{ 0 };
+
+            for (size_t i = 0; i < m; ++i)
+                p += c[i] * discount(u[i]);
+
+            return p;
+        }
+    };
+
+    // immutable piecewise flat curve
+    template<class T = double, class F = double>
+    class curve {
+        std::vector<T> t_;
+        std::vector<F> f_, I_;
+        F _f_;
+    public:
+        curve(size_t n = 0, const T* t = nullptr, const F* f = nullptr,
+            const F& _f = std::numeric_limits<F>::quiet_NaN())
+            : t_(t, t + n), f_(f, f + n), I_(n), _f_(_f)
+        {
+            cumulative(n, t, f, I_.data());
+        }
+
+        size_t size() const noexcept
+        {
+            return t_.size();
+        }
+        const T* time() const noexcept
+        {
+            return t_.data();
+        }
+        const F* forward() const noexcept
+        {
+            return f_.data();
+        }
+        // forward past the last curve time
+        const F& extrapolate() const noexcept
+        {
+            return _f_;
+        }
+        pwflat::view<T, F> view() const noexcept
+        {
+            return pwflat::view<T, F>{ size(), time(), forward(), I_.data(), _f_ };
+        }
+
+        F value(const T& u) const noexcept
+        {
+            return pwflat::value(u, size(), time(), forward(), _f_);
+        }
+        F integral(const T& u) const noexcept
+        {
+            return view().integral(u);
+        }
+        F discount(const T& u) const noexcept
+        {
+            return view().discount(u);
+        }
+        F spot(const T& u) const noexcept
+        {
+            return pwflat::spot(u, size(), time(), forward(), _f_);
+        }
+        F present_value(size_t m, const T* u, const F* c) const noexcept
+        {
+            return view().present_value(m, u, c);
+        }
+    };
+
+} // fms::pwflat
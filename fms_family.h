@@ -0,0 +1,121 @@
+// fms_family.h - Curves sharing the same times and differing only in forwards.
+// The forwards of member j at time t[i] are stored at f[i*k + j] so a single
+// search for u gives the segment for every member.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "fms_pwflat.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class family {
+        size_t k;
+        std::vector<T> t;
+        std::vector<F> f, I, _f;
+
+        // t[i-1] < u <= t[i]
+        size_t segment(const T& u) const noexcept
+        {
+            return std::lower_bound(t.begin(), t.end(), u) - t.begin();
+        }
+    public:
+        // k members with forwards f_[j*n + i] at times t_[i] and extrapolation _f_[j]
+        family(size_t n, const T* t_, size_t k_, const F* f_, const F* _f_ = nullptr)
+            : k(k_), t(t_, t_ + n), f(n * k_), I(n * k_), _f(k_, std::numeric_limits<F>::quiet_NaN())
+        {
+            for (size_t j = 0; j < k; ++j) {
+                F I_{ 0 };
+                T t0{ 0 };
+                for (size_t i = 0; i < n; ++i) {
+                    f[i * k + j] = f_[j * n + i];
+                    I_ += f_[j * n + i] * (t[i] - t0);
+                    I[i * k + j] = I_;
+                    t0 = t[i];
+                }
+                if (_f_)
+                    _f[j] = _f_[j];
+            }
+        }
+
+        // number of members
+        size_t size() const noexcept
+        {
+            return k;
+        }
+        size_t times() const noexcept
+        {
+            return t.size();
+        }
+        const T* time() const noexcept
+        {
+            return t.data();
+        }
+
+        // v[j] = f_j(u) for all members
+        void value(const T& u, F* v) const noexcept
+        {
+            if (u < 0) {
+                std::fill(v, v + k, std::numeric_limits<F>::quiet_NaN());
+
+                return;
+            }
+
+            size_t i = segment(u);
+            const F* fi = i == times() ? _f.data() : f.data() + i * k;
+            std::copy(fi, fi + k, v);
+        }
+
+        // I_[j] = int_0^u f_j(t) dt for all members
+        void integral(const T& u, F* I_) const noexcept
+        {
+            if (u < 0) {
+                std::fill(I_, I_ + k, std::numeric_limits<F>::quiet_NaN());
+
+                return;
+            }
+
+            size_t i = segment(u);
+            T du = u - (i == 0 ? 0 : t[i - 1]);
+            const F* fi = i == times() ? _f.data() : f.data() + i * k;
+            if (i == 0) {
+                for (size_t j = 0; j < k; ++j)
+                    I_[j] = fi[j] * du;
+            }
+            else {
+                const F* Ii = I.data() + (i - 1) * k;
+                for (size_t j = 0; j < k; ++j)
+                    I_[j] = Ii[j] + fi[j] * du;
+            }
+        }
+
+        // D[j] = D_j(u) for all members
+        void discount(const T& u, F* D) const noexcept
+        {
+            integral(u, D);
+            for (size_t j = 0; j < k; ++j)
+                D[j] = exp(-D[j]);
+        }
+
+        // D[l*k + j] = D_j(u[l]) for all members at m times
+        void discount(size_t m, const T* u, F* D) const noexcept
+        {
+            for (size_t l = 0; l < m; ++l)
+                discount(u[l], D + l * k);
+        }
+
+        // pv[j] = sum_i c[i] D_j(u[i]) for all members using scratch D[k]
+        void present_value(size_t m, const T* u, const F* c, F* pv, F* D) const noexcept
+        {
+            std::fill(pv, pv + k, F(0));
+            for (size_t l = 0; l < m; ++l) {
+                discount(u[l], D);
+                for (size_t j = 0; j < k; ++j)
+                    pv[j] += c[l] * D[j];
+            }
+        }
+    };
+
+} // fms::pwflat
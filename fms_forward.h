@@ -0,0 +1,48 @@
+// fms_forward.h - Forward discounts and simple forward rates for accrual periods.
+// Period endpoints are merged and discounted once per distinct date, so adjacent
+// periods sharing an endpoint share the curve evaluation.
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "fms_pwflat.h"
+
+namespace fms::pwflat {
+
+    // Forward discount D[i] = D(u[i])/D(s[i]) and simple forward rate
+    // r[i] = (D(s[i])/D(u[i]) - 1)/a[i] for periods s[i] < u[i] with s and u increasing.
+    // The day count fraction a[i] defaults to u[i] - s[i]. r and a may be null.
+    template<class T, class F>
+    inline void forwards(size_t m, const T* s, const T* u, F* D, identity_t<F>* r,
+        size_t n, const T* t, const F* f, const F& _f = std::numeric_limits<F>::quiet_NaN(),
+        const identity_t<F>* a = nullptr)
+    {
+        std::vector<T> x(2 * m);
+        std::merge(s, s + m, u, u + m, x.begin());
+        x.erase(std::unique(x.begin(), x.end()), x.end());
+
+        std::vector<F> Dx(x.size());
+        discounts(x.size(), x.data(), Dx.data(), n, t, f, _f);
+
+        size_t j = 0, k = 0;
+        for (size_t i = 0; i < m; ++i) {
+            while (x[j] < s[i])
+                ++j;
+            while (x[k] < u[i])
+                ++k;
+            D[i] = Dx[k] / Dx[j];
+            if (r)
+                r[i] = (Dx[j] / Dx[k] - 1) / (a ? a[i] : static_cast<F>(u[i] - s[i]));
+        }
+    }
+
+    // Forward discounts and simple forward rates for schedule d[0] < ... < d[p].
+    template<class T, class F>
+    inline void forwards(size_t p, const T* d, F* D, identity_t<F>* r,
+        size_t n, const T* t, const F* f, const F& _f = std::numeric_limits<F>::quiet_NaN(),
+        const identity_t<F>* a = nullptr)
+    {
+        forwards(p, d, d + 1, D, r, n, t, f, _f, a);
+    }
+
+} // fms::pwflat
@@ -0,0 +1,62 @@
+// fms_grid.h - Evaluate a curve on a uniform grid.
+// Inside a flat segment D(u + h) = D(u) exp(-f h), so each segment needs
+// one exp to start and one for the step factor instead of one per point.
+#pragma once
+#include <cmath>
+#include <limits>
+#include "fms_pwflat.h"
+
+namespace fms::pwflat {
+
+    // Discount D[k], spot r[k] and forward v[k] at u0 + k h for k < g.
+    // Any of D, r, v may be null. The grid must be increasing (h > 0).
+    template<class T, class F>
+    inline void grid(size_t g, const T& u0, const T& h,
+        identity_t<F>* D, identity_t<F>* r, identity_t<F>* v,
+        size_t n, const T* t, const F* f, const F& _f = std::numeric_limits<F>::quiet_NaN()) noexcept
+    {
+        F I_{ 0 };  // int_0^t[j-1] f(t) dt
+        T t_{ 0 };  // t[j-1]
+        size_t j = 0;
+        size_t j_ = n + 1; // segment of previous point
+        F D_{ 0 }, e{ 0 };
+
+        for (size_t k = 0; k < g; ++k) {
+            T u = u0 + static_cast<T>(k) * h;
+            if (u < 0) {
+                if (D)
+                    D[k] = std::numeric_limits<F>::quiet_NaN();
+                if (r)
+                    r[k] = std::numeric_limits<F>::quiet_NaN();
+                if (v)
+                    v[k] = std::numeric_limits<F>::quiet_NaN();
+
+                continue;
+            }
+            // t[j-1] < u <= t[j]
+            while (j < n && t[j] < u) {
+                I_ += f[j] * (t[j] - t_);
+                t_ = t[j];
+                ++j;
+            }
+            F fj = j == n ? _f : f[j];
+            F I = I_ + fj * (u - t_);
+            if (j == j_) {
+                D_ *= e;
+            }
+            else {
+                D_ = exp(-I);
+                e = exp(-fj * h);
+                j_ = j;
+            }
+
+            if (D)
+                D[k] = D_;
+            if (r)
+                r[k] = u == 0 ? fj : I / u;
+            if (v)
+                v[k] = fj;
+        }
+    }
+
+} // fms::pwflat
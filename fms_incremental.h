@@ -0,0 +1,94 @@
+// fms_incremental.h - Reprice only instruments affected by a curve change.
+// If two curves agree up to time t[k-1] then so do their discounts, and an
+// instrument whose last cash flow is at or before t[k-1] keeps its value.
+#pragma once
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include "fms_curve.h"
+#include "fms_portfolio.h"
+
+namespace fms::pwflat {
+
+    // First segment where curves differ: n if only the extrapolation differs,
+    // and n + 1 if the curves are the same.
+    template<class T, class F>
+    inline size_t first_change(const curve<T, F>& c0, const curve<T, F>& c1) noexcept
+    {
+        size_t n = std::min(c0.size(), c1.size());
+        size_t k = 0;
+        while (k < n && c0.time()[k] == c1.time()[k] && c0.forward()[k] == c1.forward()[k])
+            ++k;
+        if (k < n || c0.size() != c1.size())
+            return k;
+        // NaN extrapolations are the same
+        F _f0 = c0.extrapolate(), _f1 = c1.extrapolate();
+
+        return _f0 == _f1 || (_f0 != _f0 && _f1 != _f1) ? n + 1 : n;
+    }
+
+    template<class T = double, class F = double>
+    class incremental {
+        const portfolio<T, F>* pf;
+        curve<T, F> c;
+        std::vector<size_t> order; // instruments by increasing last cash flow time
+        std::vector<T> last;       // last cash flow time in that order
+        std::vector<F> pv;
+        F total_;
+    public:
+        // The portfolio must outlive this object and not change.
+        incremental(const portfolio<T, F>& pf_, curve<T, F> c_)
+            : pf(&pf_), c(std::move(c_)), order(pf_.size()), last(pf_.size()), pv(pf_.size()), total_(0)
+        {
+            std::iota(order.begin(), order.end(), size_t(0));
+            auto end = [this](size_t k) {
+                return pf->size(k) ? pf->time(k)[pf->size(k) - 1] : T(0);
+            };
+            std::sort(order.begin(), order.end(), [&end](size_t i, size_t j) { return end(i) < end(j); });
+            for (size_t i = 0; i < order.size(); ++i)
+                last[i] = end(order[i]);
+
+            for (size_t k = 0; k < pf->size(); ++k) {
+                pv[k] = pf->present_value(k, c.view());
+                total_ += pv[k];
+            }
+        }
+
+        const curve<T, F>& base() const noexcept
+        {
+            return c;
+        }
+        F total() const noexcept
+        {
+            return total_;
+        }
+        F present_value(size_t k) const noexcept
+        {
+            return pv[k];
+        }
+
+        // Replace the curve and return the number of instruments repriced.
+        size_t update(curve<T, F> c_)
+        {
+            size_t k = first_change(c, c_);
+            c = std::move(c_);
+            if (k > c.size())
+                return 0;
+
+            // instruments with last cash flow after t[k-1]
+            size_t i0 = k == 0 ? 0 : std::upper_bound(last.begin(), last.end(), c.time()[k - 1]) - last.begin();
+            F dp{ 0 };
+            for (size_t i = i0; i < order.size(); ++i) {
+                size_t j = order[i];
+                F pj = pf->present_value(j, c.view());
+                dp += pj - pv[j];
+                pv[j] = pj;
+            }
+            total_ += dp;
+
+            return order.size() - i0;
+        }
+    };
+
+} // fms::pwflat
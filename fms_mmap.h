@@ -0,0 +1,187 @@
+// fms_mmap.h - Map files and named shared memory into the address space.
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <system_error>
+#include <utility>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fms {
+
+    // RAII memory mapping
+    class mapping {
+        void* p = nullptr;
+        size_t n = 0;
+#ifdef _WIN32
+        HANDLE h = nullptr;
+#endif
+        void close() noexcept
+        {
+#ifdef _WIN32
+            if (p)
+                UnmapViewOfFile(p);
+            if (h)
+                CloseHandle(h);
+            h = nullptr;
+#else
+            if (p)
+                munmap(p, n);
+#endif
+            p = nullptr;
+            n = 0;
+        }
+        [[noreturn]] static void fail(const char* what)
+        {
+#ifdef _WIN32
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+            throw std::system_error(errno, std::generic_category(), what);
+#endif
+        }
+    public:
+        mapping() noexcept
+        { }
+        mapping(const mapping&) = delete;
+        mapping& operator=(const mapping&) = delete;
+        mapping(mapping&& m) noexcept
+        {
+            *this = std::move(m);
+        }
+        mapping& operator=(mapping&& m) noexcept
+        {
+            if (this != &m) {
+                close();
+                p = std::exchange(m.p, nullptr);
+                n = std::exchange(m.n, 0);
+#ifdef _WIN32
+                h = std::exchange(m.h, nullptr);
+#endif
+            }
+
+            return *this;
+        }
+        ~mapping()
+        {
+            close();
+        }
+
+        void* data() const noexcept
+        {
+            return p;
+        }
+        size_t size() const noexcept
+        {
+            return n;
+        }
+
+        // Read-write view of the named shared memory segment.
+        // Create a segment of size n if n > 0, otherwise open an existing segment.
+        static mapping shared(const char* name, size_t n = 0)
+        {
+            mapping m;
+#ifdef _WIN32
+            if (n > 0) {
+                m.h = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                    static_cast<DWORD>(static_cast<unsigned long long>(n) >> 32), static_cast<DWORD>(n), name);
+            }
+            else {
+                m.h = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+            }
+            if (!m.h)
+                fail("CreateFileMapping");
+            m.p = MapViewOfFile(m.h, FILE_MAP_ALL_ACCESS, 0, 0, n);
+            if (!m.p)
+                fail("MapViewOfFile");
+            if (n == 0) {
+                MEMORY_BASIC_INFORMATION mbi;
+                VirtualQuery(m.p, &mbi, sizeof(mbi));
+                n = mbi.RegionSize;
+            }
+#else
+            int fd = shm_open(name, n > 0 ? O_RDWR | O_CREAT : O_RDWR, 0600);
+            if (fd == -1)
+                fail("shm_open");
+            struct stat st;
+            if (fstat(fd, &st) == -1 || (n > 0 && static_cast<size_t>(st.st_size) < n && ftruncate(fd, n) == -1)) {
+                ::close(fd);
+                fail("ftruncate");
+            }
+            if (n == 0)
+                n = st.st_size;
+            m.p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (m.p == MAP_FAILED) {
+                m.p = nullptr;
+                fail("mmap");
+            }
+#endif
+            m.n = n;
+
+            return m;
+        }
+
+        // Read-only view of an entire file.
+        static mapping file(const char* path)
+        {
+            mapping m;
+#ifdef _WIN32
+            HANDLE fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (fh == INVALID_HANDLE_VALUE)
+                fail("CreateFile");
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(fh, &size)) {
+                CloseHandle(fh);
+                fail("GetFileSizeEx");
+            }
+            m.h = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(fh);
+            if (!m.h)
+                fail("CreateFileMapping");
+            m.p = MapViewOfFile(m.h, FILE_MAP_READ, 0, 0, 0);
+            if (!m.p)
+                fail("MapViewOfFile");
+            m.n = static_cast<size_t>(size.QuadPart);
+#else
+            int fd = ::open(path, O_RDONLY);
+            if (fd == -1)
+                fail("open");
+            struct stat st;
+            if (fstat(fd, &st) == -1) {
+                ::close(fd);
+                fail("fstat");
+            }
+            m.n = st.st_size;
+            m.p = mmap(nullptr, m.n, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (m.p == MAP_FAILED) {
+                m.p = nullptr;
+                fail("mmap");
+            }
+#endif
+
+            return m;
+        }
+
+        // Remove the name of a shared memory segment. Existing mappings stay valid.
+        static void unlink(const char* name) noexcept
+        {
+#ifdef _WIN32
+            // segments are freed when the last handle is closed
+            (void)name;
+#else
+            shm_unlink(name);
+#endif
+        }
+    };
+
+} // namespace fms
@@ -0,0 +1,122 @@
+// fms_netting.h - Net portfolio cash flows by curve and payment time.
+// After compress() curve k has one net cash flow c[i] per distinct time u[i]
+// for i in [off[k], off[k+1]), so discounting is done once per date.
+#pragma once
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include "fms_curve.h"
+#include "fms_portfolio.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class ladder {
+        std::vector<size_t> id; // curve of each cash flow
+        std::vector<T> u;
+        std::vector<F> c;
+        std::vector<size_t> off;
+        bool compressed;
+    public:
+        ladder()
+            : off{ 0 }, compressed(true)
+        { }
+
+        // Add cash flows to be discounted by curve k.
+        void add(size_t k, size_t m, const T* u_, const F* c_)
+        {
+            id.insert(id.end(), m, k);
+            u.insert(u.end(), u_, u_ + m);
+            c.insert(c.end(), c_, c_ + m);
+            compressed = false;
+        }
+        // Add all cash flows of a portfolio to be discounted by curve k.
+        void add(size_t k, const portfolio<T, F>& pf)
+        {
+            for (size_t i = 0; i < pf.size(); ++i)
+                add(k, pf.size(i), pf.time(i), pf.cash(i));
+        }
+
+        // Sort by curve and time and sum cash flows at the same time.
+        void compress()
+        {
+            if (compressed)
+                return;
+
+            std::vector<size_t> p(u.size());
+            std::iota(p.begin(), p.end(), size_t(0));
+            std::sort(p.begin(), p.end(), [this](size_t i, size_t j) {
+                return id[i] < id[j] || (id[i] == id[j] && u[i] < u[j]);
+            });
+
+            std::vector<size_t> id_;
+            std::vector<T> u_;
+            std::vector<F> c_;
+            for (size_t i : p) {
+                if (!u_.empty() && id_.back() == id[i] && u_.back() == u[i]) {
+                    c_.back() += c[i];
+                }
+                else {
+                    id_.push_back(id[i]);
+                    u_.push_back(u[i]);
+                    c_.push_back(c[i]);
+                }
+            }
+            id.swap(id_);
+            u.swap(u_);
+            c.swap(c_);
+
+            off.assign(id.empty() ? 1 : id.back() + 2, 0);
+            for (size_t k : id)
+                ++off[k + 1];
+            std::partial_sum(off.begin(), off.end(), off.begin());
+
+            compressed = true;
+        }
+
+        // number of curves, valid after compress()
+        size_t curves() const noexcept
+        {
+            return off.size() - 1;
+        }
+        // number of distinct times for curve k
+        size_t size(size_t k) const noexcept
+        {
+            return off[k + 1] - off[k];
+        }
+        // total number of distinct (curve, time) pairs
+        size_t size() const noexcept
+        {
+            return u.size();
+        }
+        const T* time(size_t k) const noexcept
+        {
+            return u.data() + off[k];
+        }
+        const F* cash(size_t k) const noexcept
+        {
+            return c.data() + off[k];
+        }
+
+        F present_value(size_t k, const view<T, F>& v) const noexcept
+        {
+            return v.present_value(size(k), time(k), cash(k));
+        }
+        // derivative of present value wrt parallel shift of curve k
+        F duration(size_t k, const view<T, F>& v) const noexcept
+        {
+            F d{ 0 };
+
+            for (size_t i = off[k]; i < off[k + 1]; ++i)
+                d -= u[i] * c[i] * v.discount(u[i]);
+
+            return d;
+        }
+        // derivatives d[j] wrt f[j], j < n, and _f of curve k
+        void key_rate(size_t k, const view<T, F>& v, F* d) const noexcept
+        {
+            pwflat::key_rate(size(k), time(k), cash(k), v.n, v.t, v.f, v.I, d, v._f);
+        }
+    };
+
+} // fms::pwflat
@@ -0,0 +1,37 @@
+// fms_par.h - Par swap rates for a ladder of tenors sharing one coupon schedule.
+// The annuity of each tenor is a prefix sum of discounted accruals, so all tenors
+// are priced in one pass over the schedule.
+#pragma once
+#include <limits>
+#include <vector>
+#include <gsl/gsl>
+#include "fms_pwflat.h"
+
+namespace fms::pwflat {
+
+    // Par rate rate[j] and PV01 pv01[j] of the unit notional swap starting at t0 with
+    // fixed coupons at u[i] with accrual a[i], i < e[j], for increasing 0 < e[j] <= m.
+    // The float leg is worth D(t0) - D(u[e[j] - 1]). pv01 may be null.
+    template<class T, class F>
+    inline void par(const T& t0, size_t m, const T* u, const F* a, size_t k, const size_t* e,
+        F* rate, identity_t<F>* pv01,
+        size_t n, const T* t, const F* f, const F& _f = std::numeric_limits<F>::quiet_NaN())
+    {
+        std::vector<F> D(m);
+        discounts(m, u, D.data(), n, t, f, _f);
+        F D0;
+        discounts(1, &t0, &D0, n, t, f, _f);
+
+        F A{ 0 };
+        size_t i = 0;
+        for (size_t j = 0; j < k; ++j) {
+            Expects(e[j] > 0 && e[j] <= m);
+            for (; i < e[j]; ++i)
+                A += a[i] * D[i];
+            rate[j] = (D0 - D[e[j] - 1]) / A;
+            if (pv01)
+                pv01[j] = A / 10000;
+        }
+    }
+
+} // fms::pwflat
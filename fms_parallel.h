@@ -0,0 +1,173 @@
+// fms_parallel.h - Run loops on multiple threads.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4324) // structure was padded due to alignment specifier
+#endif
+
+namespace fms {
+
+    // number of threads to use if 0 is requested
+    inline size_t threads(size_t p = 0) noexcept
+    {
+        if (p == 0)
+            p = std::thread::hardware_concurrency();
+
+        return p == 0 ? 1 : p;
+    }
+
+    // Call op(i) for i < k with each thread taking a contiguous block of indices.
+    template<class Op>
+    inline void parallel_for(size_t k, Op op, size_t p = 0)
+    {
+        p = std::min(threads(p), k);
+        if (p <= 1) {
+            for (size_t i = 0; i < k; ++i)
+                op(i);
+
+            return;
+        }
+
+        std::vector<std::thread> pool;
+        pool.reserve(p);
+        for (size_t j = 0; j < p; ++j) {
+            pool.emplace_back([=, &op]() {
+                for (size_t i = j * k / p; i < (j + 1) * k / p; ++i)
+                    op(i);
+            });
+        }
+        for (auto& th : pool)
+            th.join();
+    }
+
+    // Call op(i) for i < k using p threads that steal work from each other.
+    // Thread j starts on the j-th contiguous block of indices and, when it is done,
+    // claims remaining indices from the other blocks.
+    template<class Op>
+    inline void work_steal(size_t k, Op op, size_t p = 0)
+    {
+        p = std::min(threads(p), k);
+        if (p <= 1) {
+            for (size_t i = 0; i < k; ++i)
+                op(i);
+
+            return;
+        }
+
+        // next unclaimed index of each block on its own cache line
+        struct alignas(64) block {
+            std::atomic<size_t> next;
+            size_t end;
+        };
+        std::unique_ptr<block[]> b(new block[p]);
+        for (size_t j = 0; j < p; ++j) {
+            b[j].next = j * k / p;
+            b[j].end = (j + 1) * k / p;
+        }
+
+        std::vector<std::thread> pool;
+        pool.reserve(p);
+        for (size_t j = 0; j < p; ++j) {
+            pool.emplace_back([=, &b, &op]() {
+                for (size_t v = 0; v < p; ++v) {
+                    block& bv = b[(j + v) % p];
+                    for (size_t i = bv.next++; i < bv.end; i = bv.next++)
+                        op(i);
+                }
+            });
+        }
+        for (auto& th : pool)
+            th.join();
+    }
+
+    // Boundaries 0 = b[0] < b[1] < ... = k splitting [0, k) into at most
+    // c contiguous chunks of roughly equal total weight w(i).
+    template<class W>
+    inline std::vector<size_t> partition(size_t k, W w, size_t c)
+    {
+        double total = 0;
+        for (size_t i = 0; i < k; ++i)
+            total += static_cast<double>(w(i));
+
+        std::vector<size_t> b{ 0 };
+        double sum = 0;
+        size_t j = 1;
+        for (size_t i = 0; i + 1 < k; ++i) {
+            sum += static_cast<double>(w(i));
+            if (j < c && sum >= total * j / c) {
+                b.push_back(i + 1);
+                while (j < c && sum >= total * j / c)
+                    ++j;
+            }
+        }
+        if (k > 0)
+            b.push_back(k);
+
+        return b;
+    }
+
+    // pairwise sum of x[0], ..., x[k-1]
+    template<class F>
+    inline F pairwise(size_t k, const F* x) noexcept
+    {
+        if (k == 0)
+            return F(0);
+        if (k == 1)
+            return x[0];
+
+        return pairwise(k / 2, x) + pairwise(k - k / 2, x + k / 2);
+    }
+
+    // Sum of x(i) for i < k using p threads that is the same for any p.
+    // Blocks of b terms are summed in order and the block sums are added pairwise.
+    template<class F, class X>
+    inline F sum(size_t k, X x, size_t p = 0, size_t b = 1024)
+    {
+        size_t nb = (k + b - 1) / b;
+        std::vector<F> s(nb);
+
+        work_steal(nb, [&](size_t j) {
+            F sj{ 0 };
+            for (size_t i = j * b; i < std::min(k, (j + 1) * b); ++i)
+                sj += x(i);
+            s[j] = sj;
+        }, p);
+
+        return pairwise(nb, s.data());
+    }
+
+    // Vector sum s[0], ..., s[d-1] of terms i < k using p threads that is the same for any p.
+    // x(i, a) adds term i to a[0], ..., a[d-1].
+    template<class F, class X>
+    inline void sum(size_t k, size_t d, X x, F* s, size_t p = 0, size_t b = 1024)
+    {
+        size_t nb = (k + b - 1) / b;
+        std::vector<F> a(nb * d, F(0));
+
+        work_steal(nb, [&](size_t j) {
+            for (size_t i = j * b; i < std::min(k, (j + 1) * b); ++i)
+                x(i, a.data() + j * d);
+        }, p);
+
+        // pairwise over blocks for each component
+        for (size_t w = 1; w < nb; w *= 2) {
+            for (size_t j = 0; j + w < nb; j += 2 * w) {
+                for (size_t l = 0; l < d; ++l)
+                    a[j * d + l] += a[(j + w) * d + l];
+            }
+        }
+        for (size_t l = 0; l < d; ++l)
+            s[l] = nb ? a[l] : F(0);
+    }
+
+} // namespace fms
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
@@ -0,0 +1,135 @@
+// fms_portfolio.h - Instruments stored as contiguous cash flow arrays.
+// Instrument k has cash flows c[off[k]], ..., c[off[k+1] - 1] at times u[off[k]], ...
+#pragma once
+#include <limits>
+#include <vector>
+#include "fms_curve.h"
+#include "fms_parallel.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class portfolio {
+        std::vector<size_t> off;
+        std::vector<T> u;
+        std::vector<F> c;
+    public:
+        portfolio()
+            : off{ 0 }
+        { }
+
+        void reserve(size_t instruments, size_t cash_flows)
+        {
+            off.reserve(instruments + 1);
+            u.reserve(cash_flows);
+            c.reserve(cash_flows);
+        }
+
+        // number of instruments
+        size_t size() const noexcept
+        {
+            return off.size() - 1;
+        }
+        // total number of cash flows
+        size_t cash_flows() const noexcept
+        {
+            return u.size();
+        }
+
+        // Append an instrument with increasing cash flow times and return its index.
+        size_t add(size_t m, const T* u_, const F* c_)
+        {
+            u.insert(u.end(), u_, u_ + m);
+            c.insert(c.end(), c_, c_ + m);
+            off.push_back(u.size());
+
+            return size() - 1;
+        }
+
+        // index of the first cash flow of instrument k
+        size_t offset(size_t k) const noexcept
+        {
+            return off[k];
+        }
+        // number of cash flows of instrument k
+        size_t size(size_t k) const noexcept
+        {
+            return off[k + 1] - off[k];
+        }
+        const T* time(size_t k) const noexcept
+        {
+            return u.data() + off[k];
+        }
+        const F* cash(size_t k) const noexcept
+        {
+            return c.data() + off[k];
+        }
+
+        F present_value(size_t k, size_t n, const T* t, const F* f,
+            const F& _f = std::numeric_limits<F>::quiet_NaN()) const noexcept
+        {
+            return pwflat::present_value(size(k), time(k), cash(k), n, t, f, _f);
+        }
+        // sum of instrument present values in index order
+        F total(size_t n, const T* t, const F* f,
+            const F& _f = std::numeric_limits<F>::quiet_NaN()) const noexcept
+        {
+            F p{ 0 };
+
+            for (size_t k = 0; k < size(); ++k)
+                p += present_value(k, n, t, f, _f);
+
+            return p;
+        }
+
+        F present_value(size_t k, const view<T, F>& v) const noexcept
+        {
+            return v.present_value(size(k), time(k), cash(k));
+        }
+        // pv[k] = present value of instrument k using p threads.
+        // Chunks of instruments with about the same number of cash flows are
+        // scheduled by work stealing.
+        void present_value(const view<T, F>& v, F* pv, size_t p = 0) const
+        {
+            p = threads(p);
+            auto b = partition(size(), [this](size_t k) { return size(k); }, 16 * p);
+
+            work_steal(b.size() - 1, [&](size_t j) {
+                for (size_t k = b[j]; k < b[j + 1]; ++k)
+                    pv[k] = present_value(k, v);
+            }, p);
+        }
+        F total(const view<T, F>& v) const noexcept
+        {
+            F p{ 0 };
+
+            for (size_t k = 0; k < size(); ++k)
+                p += present_value(k, v);
+
+            return p;
+        }
+        // total present value using p threads that is the same for any p
+        F total(const view<T, F>& v, size_t p) const
+        {
+            return sum<F>(size(), [&](size_t k) { return present_value(k, v); }, p);
+        }
+
+        // add derivatives of the present value of instrument k wrt f[j], j < n, and _f to d[j]
+        void key_rate(size_t k, const view<T, F>& v, F* d) const noexcept
+        {
+            const T* u_ = time(k);
+            const F* c_ = cash(k);
+            for (size_t i = 0; i < size(k); ++i) {
+                F cD = c_[i] * v.discount(u_[i]);
+                for (size_t j = 0; j <= v.n && (j == 0 || v.t[j - 1] < u_[i]); ++j)
+                    d[j] -= overlap(j, u_[i], v.n, v.t) * cD;
+            }
+        }
+        // portfolio key rate derivatives d[j], j <= n, using p threads that are the same for any p
+        void key_rate(const view<T, F>& v, F* d, size_t p = 0) const
+        {
+            sum<F>(size(), v.n + 1, [&](size_t k, F* a) { key_rate(k, v, a); }, d, p);
+        }
+    };
+
+} // fms::pwflat
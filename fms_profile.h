@@ -0,0 +1,53 @@
+// fms_profile.h - Forward present value of remaining cash flows at future dates.
+// V(s) = sum_{u[i] > s} c[i] D(u[i])/D(s) is a suffix sum of discounted cash flows
+// divided by D(s), so all dates take one pass over cash flows, dates and curve.
+#pragma once
+#include <limits>
+#include <vector>
+#include "fms_portfolio.h"
+
+namespace fms::pwflat {
+
+    // V[j] = sum_{u[i] > s[j]} c[i] D(u[i])/Ds[j] using scratch S[m + 1]
+    template<class T, class F>
+    inline void profile(size_t m, const T* u, const F* c, F* S, size_t k, const T* s, const F* Ds, F* V,
+        size_t n, const T* t, const F* f, const F& _f) noexcept
+    {
+        discounts(m, u, S, n, t, f, _f);
+        S[m] = 0;
+        for (size_t i = m; i-- > 0; )
+            S[i] = c[i] * S[i] + S[i + 1];
+
+        size_t i = 0;
+        for (size_t j = 0; j < k; ++j) {
+            while (i < m && u[i] <= s[j])
+                ++i;
+            V[j] = S[i] / Ds[j];
+        }
+    }
+
+    // V[j] = value at s[j] of cash flows after s[j] for increasing u and s
+    template<class T, class F>
+    inline void profile(size_t m, const T* u, const F* c, size_t k, const T* s, F* V,
+        size_t n, const T* t, const F* f, const F& _f = std::numeric_limits<F>::quiet_NaN())
+    {
+        std::vector<F> S(m + 1);
+        discounts(k, s, V, n, t, f, _f);
+        profile(m, u, c, S.data(), k, s, V, V, n, t, f, _f);
+    }
+
+    // V[l*k + j] = value at s[j] of cash flows of instrument l after s[j] for increasing s
+    template<class T, class F>
+    inline void profile(const portfolio<T, F>& pf, size_t k, const T* s, F* V,
+        size_t n, const T* t, const F* f, const F& _f = std::numeric_limits<F>::quiet_NaN())
+    {
+        std::vector<F> Ds(k), S;
+        discounts(k, s, Ds.data(), n, t, f, _f);
+
+        for (size_t l = 0; l < pf.size(); ++l) {
+            S.resize(pf.size(l) + 1);
+            profile(pf.size(l), pf.time(l), pf.cash(l), S.data(), k, s, Ds.data(), V + l * k, n, t, f, _f);
+        }
+    }
+
+} // fms::pwflat
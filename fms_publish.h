@@ -0,0 +1,167 @@
+// fms_publish.h - Publish curves to concurrent readers without locks.
+// Readers pin the current curve and see an immutable snapshot. The writer swaps in
+// a new curve and frees old ones only after every reader that could see them unpins.
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <gsl/gsl>
+#include "fms_curve.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4324) // structure was padded due to alignment specifier
+#endif
+
+namespace fms::pwflat {
+
+    // epoch based reclamation of curves with at most N concurrent readers
+    template<class T = double, class F = double, size_t N = 64>
+    class published {
+        // reader epoch, 0 if not pinned, on its own cache line
+        struct alignas(64) slot {
+            std::atomic<uint64_t> epoch{ 0 };
+            uint32_t depth{ 0 }; // number of live pins, only used by the owning thread
+            std::atomic<bool> used{ false };
+        };
+        static_assert(sizeof(slot) == 64);
+        std::atomic<const curve<T, F>*> current;
+        std::atomic<uint64_t> epoch{ 1 };
+        slot slots[N];
+        std::mutex writer; // serialize publishers only
+        std::vector<std::pair<uint64_t, const curve<T, F>*>> retired;
+
+        // free retired curves no pinned reader can see
+        void reclaim()
+        {
+            uint64_t e = std::numeric_limits<uint64_t>::max();
+            for (const auto& s : slots) {
+                auto se = s.epoch.load();
+                if (se != 0 && se < e)
+                    e = se;
+            }
+            auto i = retired.begin();
+            while (i != retired.end()) {
+                if (i->first < e) {
+                    delete i->second;
+                    i = retired.erase(i);
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+    public:
+        // curve snapshot valid until destroyed
+        // Nested pins keep the epoch of the outermost pin until it is destroyed.
+        class pin {
+            slot* s;
+            const curve<T, F>* p;
+        public:
+            pin(slot* s_, const std::atomic<const curve<T, F>*>& current, const std::atomic<uint64_t>& epoch) noexcept
+                : s(s_)
+            {
+                if (s->depth++ == 0)
+                    s->epoch.store(epoch.load());
+                p = current.load();
+            }
+            pin(const pin&) = delete;
+            pin& operator=(const pin&) = delete;
+            ~pin()
+            {
+                if (--s->depth == 0)
+                    s->epoch.store(0);
+            }
+
+            const curve<T, F>& operator*() const noexcept
+            {
+                return *p;
+            }
+            const curve<T, F>* operator->() const noexcept
+            {
+                return p;
+            }
+        };
+
+        // reader slot owned by one thread
+        class reader {
+            published* pub;
+            slot* s;
+        public:
+            reader(published* pub_, slot* s_) noexcept
+                : pub(pub_), s(s_)
+            { }
+            reader(const reader&) = delete;
+            reader& operator=(const reader&) = delete;
+            reader(reader&& r) noexcept
+                : pub(r.pub), s(std::exchange(r.s, nullptr))
+            { }
+            ~reader()
+            {
+                if (s)
+                    s->used.store(false);
+            }
+
+            pin read() const noexcept
+            {
+                return pin(s, pub->current, pub->epoch);
+            }
+        };
+
+        published(curve<T, F> c = curve<T, F>{})
+            : current(new curve<T, F>(std::move(c)))
+        { }
+        published(const published&) = delete;
+        published& operator=(const published&) = delete;
+        ~published()
+        {
+            for (auto& r : retired)
+                delete r.second;
+            delete current.load();
+        }
+
+        // claim a reader slot
+        reader register_reader()
+        {
+            for (auto& s : slots) {
+                bool used = false;
+                if (s.used.compare_exchange_strong(used, true))
+                    return reader(this, &s);
+            }
+
+            // no reader slots available
+            Expects(false);
+
+            return reader(this, nullptr);
+        }
+
+        // replace the current curve without blocking readers
+        void publish(curve<T, F> c)
+        {
+            auto p = new curve<T, F>(std::move(c));
+
+            std::lock_guard<std::mutex> lock(writer);
+            auto old = current.exchange(p);
+            // readers pinned after this epoch see p
+            retired.emplace_back(epoch.fetch_add(1), old);
+            reclaim();
+        }
+
+        // number of replaced curves not yet freed
+        size_t pending()
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            reclaim();
+
+            return retired.size();
+        }
+    };
+
+} // fms::pwflat
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
@@ -14,6 +14,14 @@ namespace fms::pwflat {
         return t + n == std::adjacent_find(t, t + n, std::greater_equal<T>{});
     }
 
+    // non-deduced X so optional output pointers may be passed as nullptr
+    template<class X>
+    struct identity {
+        using type = X;
+    };
+    template<class X>
+    using identity_t = typename identity<X>::type;
+
     // piecewise flat curve
     // return f[i] if t[i-1] < u <= t[i], _f if u > t[n-1], and NaN otherwise
     template<class T, class F>
@@ -52,7 +60,9 @@ namespace fms::pwflat {
             I += f[i] * (t[i] - t_);
             t_ = t[i];
         }
-        I += (n == 0 || u > t[n - 1] ? _f : f[i]) *(u - t_);
+        // t[i-1] <= u < t[i], or i == n and u == t[n-1] with nothing left to add
+        if (u > t_)
+            I += (i == n ? _f : f[i]) * (u - t_);
 
         return I;
     }
@@ -65,6 +75,69 @@ namespace fms::pwflat {
         return exp(-integral(u, n, t, f, _f));
     }
 
+    // cumulative integrals I[i] = int_0^t[i] f(t) dt
+    template<class T, class F>
+    inline void cumulative(size_t n, const T* t, const F* f, F* I) noexcept
+    {
+        F I_{ 0 };
+        T t_{ 0 };
+
+        for (size_t i = 0; i < n; ++i) {
+            I_ += f[i] * (t[i] - t_);
+            I[i] = I_;
+            t_ = t[i];
+        }
+    }
+
+    // int_0^u f(t) dt using cumulative integrals I
+    template<class T, class F>
+    inline F integral(const T& u, size_t n, const T* t, const F* f, const F* I,
+        const F& _f = std::numeric_limits<F>::quiet_NaN()) noexcept
+    {
+        if (u < 0)
+            return std::numeric_limits<F>::quiet_NaN();
+
+        // t[i-1] < u <= t[i]
+        size_t i = std::lower_bound(t, t + n, u) - t;
+        T t_ = i == 0 ? 0 : t[i - 1];
+        F I_ = i == 0 ? 0 : I[i - 1];
+
+        return I_ + (i == n ? _f : f[i]) * (u - t_);
+    }
+
+    // discount D(u) = exp(-int_0^u f(t) dt) using cumulative integrals I
+    template<class T, class F>
+    inline F discount(const T& u, size_t n, const T* t, const F* f, const F* I,
+        const F& _f = std::numeric_limits<F>::quiet_NaN()) noexcept
+    {
+        return exp(-integral(u, n, t, f, I, _f));
+    }
+
+    // D[i] = D(u[i]) for increasing u[i] in one pass over the curve
+    template<class T, class F>
+    inline void discounts(size_t m, const T* u, F* D, size_t n, const T* t, const F* f,
+        const F& _f = std::numeric_limits<F>::quiet_NaN()) noexcept
+    {
+        F I{ 0 };
+        T t_{ 0 };
+        size_t j = 0;
+
+        for (size_t i = 0; i < m; ++i) {
+            if (u[i] < 0) {
+                D[i] = std::numeric_limits<F>::quiet_NaN();
+
+                continue;
+            }
+            // t[j-1] < u[i] <= t[j]
+            while (j < n && t[j] < u[i]) {
+                I += f[j] * (t[j] - t_);
+                t_ = t[j];
+                ++j;
+            }
+            D[i] = exp(-(I + (j == n ? _f : f[j]) * (u[i] - t_)));
+        }
+    }
+
     // spot r(u) = (int_0^u f(t) dt)/u
     template<class T, class F>
     inline F spot(const T& u, size_t n, const T* t, const F* f, 
@@ -104,6 +177,31 @@ namespace fms::pwflat {
         return d;
     }
 
+    // length of segment (t[j-1], t[j]] intersected with [0, u], where t[-1] = 0 and t[n] = infinity
+    template<class T>
+    inline T overlap(size_t j, const T& u, size_t n, const T* t) noexcept
+    {
+        T t0 = j == 0 ? 0 : t[j - 1];
+        T t1 = j == n ? u : std::min(u, t[j]);
+
+        return t1 > t0 ? t1 - t0 : 0;
+    }
+
+    // derivatives d[j] of present value wrt f[j], j < n, and d[n] wrt _f using cumulative integrals I
+    template<class T, class F>
+    inline void key_rate(size_t m, const T* u, const F* c, size_t n, const T* t, const F* f, const F* I, F* d,
+        const F& _f = std::numeric_limits<F>::quiet_NaN()) noexcept
+    {
+        for (size_t j = 0; j <= n; ++j)
+            d[j] = 0;
+
+        for (size_t i = 0; i < m; ++i) {
+            F cD = c[i] * pwflat::discount(u[i], n, t, f, I, _f);
+            for (size_t j = 0; j <= n && (j == 0 || t[j - 1] < u[i]); ++j)
+                d[j] -= overlap(j, u[i], n, t) * cD;
+        }
+    }
+
     // derivative of present value wrt parallel shift of forward curve after last curve time
     template<class T, class F>
     inline F partial_duration(size_t m, const T* u, const F* c, size_t n, const T* t, const F* f, 
@@ -0,0 +1,58 @@
+// fms_roll.h - Theta from rolling the valuation date forward.
+// At a later date s the remaining cash flows are worth sum_{u > s} c D(u)/D(s) and
+// cash paid by s is carried to s at the forward, worth sum_{u <= s} c D(u)/D(s),
+// so today's and the rolled present value share one discount per cash flow.
+#pragma once
+#include "fms_bump.h"
+#include "fms_portfolio.h"
+
+namespace fms::pwflat {
+
+    // curve seen from time s
+    template<class T, class F>
+    inline rolled<T, F> roll(const view<T, F>& v, const T& s) noexcept
+    {
+        return rolled<T, F>(v, s);
+    }
+
+    // Theta of instrument k rolled to time s > 0 with the curve realizing its forwards:
+    // value at s of cash flows after s plus cash paid by s carried to s, minus value today.
+    // If paid is not null it is set to the carried paid cash included in theta.
+    template<class T, class F>
+    inline F theta(const portfolio<T, F>& pf, size_t k, const view<T, F>& v, const T& s,
+        const F& Ds, identity_t<F>* paid = nullptr) noexcept
+    {
+        const T* u = pf.time(k);
+        const F* c = pf.cash(k);
+        F p0{ 0 }, q{ 0 };
+
+        for (size_t i = 0; i < pf.size(k); ++i) {
+            F cD = c[i] * v.discount(u[i]);
+            p0 += cD;
+            if (u[i] <= s)
+                q += cD;
+        }
+        if (paid)
+            *paid = q / Ds;
+
+        return p0 / Ds - p0;
+    }
+
+    // Theta of the book rolled to time s using p threads that is the same for any p.
+    // If th is not null th[k] is the theta of instrument k and if paid is not null
+    // paid[k] is its carried paid cash.
+    template<class T, class F>
+    inline F theta(const portfolio<T, F>& pf, const view<T, F>& v, const T& s,
+        identity_t<F>* th = nullptr, identity_t<F>* paid = nullptr, size_t p = 0)
+    {
+        F Ds = v.discount(s);
+
+        return sum<F>(pf.size(), [&](size_t k) {
+            F x = theta(pf, k, v, s, Ds, paid ? paid + k : nullptr);
+            if (th)
+                th[k] = x;
+            return x;
+        }, p);
+    }
+
+} // fms::pwflat
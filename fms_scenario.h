@@ -0,0 +1,97 @@
+// fms_scenario.h - Scenarios stored as sparse forward changes to a base curve.
+// Scenario s adds df to the forward on segment (t[i-1], t[i]] for each of its
+// (i, df) pairs, where i = n is the extrapolation past the last curve time.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <gsl/gsl>
+#include "fms_curve.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class scenarios {
+        curve<T, F> base_;
+        std::vector<size_t> off; // scenario s has pairs [off[s], off[s+1])
+        std::vector<size_t> knot;
+        std::vector<F> delta;
+    public:
+        scenarios(curve<T, F> base)
+            : base_(std::move(base)), off{ 0 }
+        { }
+
+        const curve<T, F>& base() const noexcept
+        {
+            return base_;
+        }
+        // number of scenarios
+        size_t size() const noexcept
+        {
+            return off.size() - 1;
+        }
+
+        // Add scenario with forward changes df[j] on segments i[j] and return its index.
+        size_t add(size_t m, const size_t* i, const F* df)
+        {
+            for (size_t j = 0; j < m; ++j) {
+                Expects(i[j] <= base_.size());
+                knot.push_back(i[j]);
+                delta.push_back(df[j]);
+            }
+            off.push_back(knot.size());
+
+            return size() - 1;
+        }
+
+        // int_0^u of the forward change in scenario s
+        F integral(size_t s, const T& u) const noexcept
+        {
+            F I{ 0 };
+
+            for (size_t j = off[s]; j < off[s + 1]; ++j)
+                I += delta[j] * overlap(knot[j], u, base_.size(), base_.time());
+
+            return I;
+        }
+
+        // D_s(u) = D(u) exp(-int_0^u df(t) dt)
+        F discount(size_t s, const T& u) const noexcept
+        {
+            return base_.discount(u) * exp(-integral(s, u));
+        }
+
+        // D[s] = D_s(u) for all scenarios
+        void discount(const T& u, F* D) const noexcept
+        {
+            F D_ = base_.discount(u);
+
+            for (size_t s = 0; s < size(); ++s)
+                D[s] = D_ * exp(-integral(s, u));
+        }
+
+        // sum_i c[i] D_s(u[i])
+        F present_value(size_t s, size_t m, const T* u, const F* c) const noexcept
+        {
+            F p{ 0 };
+
+            for (size_t i = 0; i < m; ++i)
+                p += c[i] * discount(s, u[i]);
+
+            return p;
+        }
+
+        // pv[s] = sum_i c[i] D_s(u[i]) for all scenarios
+        void present_value(size_t m, const T* u, const F* c, F* pv) const noexcept
+        {
+            std::fill(pv, pv + size(), F(0));
+            for (size_t i = 0; i < m; ++i) {
+                F cD = c[i] * base_.discount(u[i]);
+                for (size_t s = 0; s < size(); ++s)
+                    pv[s] += cD * exp(-integral(s, u[i]));
+            }
+        }
+    };
+
+} // fms::pwflat
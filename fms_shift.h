@@ -0,0 +1,78 @@
+// fms_shift.h - Present value under parallel shifts and twists of the forward curve.
+// Shifting forwards by s(t) = a + b t multiplies D(u) by exp(-(a u + b u^2/2)),
+// so c D(u) is computed once per cash flow and each scenario is a single reduction.
+// A twist of size b about pivot p is a = -b p.
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "fms_pwflat.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class shift {
+        std::vector<F> u, u2, cD; // u, u^2/2, c D(u)
+    public:
+        shift(size_t m, const T* u_, const F* c, size_t n, const T* t, const F* f,
+            const F& _f = std::numeric_limits<F>::quiet_NaN())
+            : u(m), u2(m), cD(m)
+        {
+            std::vector<F> I(n);
+            cumulative(n, t, f, I.data());
+            for (size_t i = 0; i < m; ++i) {
+                u[i] = static_cast<F>(u_[i]);
+                u2[i] = u[i] * u[i] / 2;
+                cD[i] = c[i] * pwflat::discount(u_[i], n, t, f, I.data(), _f);
+            }
+        }
+
+        size_t size() const noexcept
+        {
+            return u.size();
+        }
+
+        // present value with forwards shifted by a + b t
+        F present_value(const F& a = 0, const F& b = 0) const noexcept
+        {
+            F p{ 0 };
+
+            if (b == 0) {
+                for (size_t i = 0; i < size(); ++i)
+                    p += cD[i] * exp(-a * u[i]);
+            }
+            else {
+                for (size_t i = 0; i < size(); ++i)
+                    p += cD[i] * exp(-a * u[i] - b * u2[i]);
+            }
+
+            return p;
+        }
+
+        // derivative of present value wrt a at forwards shifted by a + b t
+        F duration(const F& a = 0, const F& b = 0) const noexcept
+        {
+            F d{ 0 };
+
+            for (size_t i = 0; i < size(); ++i)
+                d -= u[i] * cD[i] * exp(-a * u[i] - b * u2[i]);
+
+            return d;
+        }
+
+        // pv[j] = present value with forwards shifted by a[j]
+        void present_value(size_t k, const F* a, F* pv) const noexcept
+        {
+            for (size_t j = 0; j < k; ++j)
+                pv[j] = present_value(a[j]);
+        }
+
+        // pv[j] = present value with forwards shifted by a[j] + b[j] t
+        void present_value(size_t k, const F* a, const F* b, F* pv) const noexcept
+        {
+            for (size_t j = 0; j < k; ++j)
+                pv[j] = present_value(a[j], b[j]);
+        }
+    };
+
+} // fms::pwflat
@@ -0,0 +1,138 @@
+// fms_shm.h - Publish a curve to other processes through shared memory.
+// One builder process writes the segment. Workers read the mapped arrays in place
+// and retry if the sequence number shows a concurrent write.
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <gsl/gsl>
+#include "fms_curve.h"
+#include "fms_mmap.h"
+
+namespace fms::pwflat {
+
+    // Segment layout: header, then t[capacity], f[capacity], I[capacity]
+    // with each array starting on a 64 byte boundary.
+    template<class T = double, class F = double>
+    class shared {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<F>);
+        static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+        static constexpr uint64_t MAGIC = 0x4d48535f4359534d; // "MSYC_SHM"
+        static constexpr uint32_t VERSION = 1;
+
+        struct header {
+            uint64_t magic;
+            uint32_t version;
+            uint16_t size_t_; // sizeof(T)
+            uint16_t size_f_; // sizeof(F)
+            uint64_t capacity;
+            std::atomic<uint64_t> seq; // odd while a write is in progress
+            std::atomic<uint64_t> n;
+            F _f;
+        };
+
+        static constexpr size_t align(size_t n) noexcept
+        {
+            return (n + 63) & ~size_t(63);
+        }
+        static size_t bytes(size_t capacity) noexcept
+        {
+            return align(sizeof(header)) + align(capacity * sizeof(T)) + 2 * align(capacity * sizeof(F));
+        }
+
+        mapping m;
+        header* h;
+        T* t;
+        F* f;
+        F* I;
+
+        explicit shared(mapping&& m_)
+            : m(std::move(m_)), h(static_cast<header*>(m.data()))
+        {
+            auto p = static_cast<char*>(m.data()) + align(sizeof(header));
+            t = reinterpret_cast<T*>(p);
+            p += align(capacity() * sizeof(T));
+            f = reinterpret_cast<F*>(p);
+            p += align(capacity() * sizeof(F));
+            I = reinterpret_cast<F*>(p);
+        }
+    public:
+        // builder side: create a segment holding up to capacity curve times
+        static shared create(const char* name, size_t capacity)
+        {
+            auto m_ = mapping::shared(name, bytes(capacity));
+            auto h_ = new (m_.data()) header{};
+            h_->magic = MAGIC;
+            h_->version = VERSION;
+            h_->size_t_ = sizeof(T);
+            h_->size_f_ = sizeof(F);
+            h_->capacity = capacity;
+            h_->_f = std::numeric_limits<F>::quiet_NaN();
+
+            return shared(std::move(m_));
+        }
+        // worker side: map an existing segment
+        static shared open(const char* name)
+        {
+            auto m_ = mapping::shared(name);
+            Expects(m_.size() >= sizeof(header));
+            auto h_ = static_cast<const header*>(m_.data());
+            Expects(h_->magic == MAGIC && h_->version == VERSION);
+            Expects(h_->size_t_ == sizeof(T) && h_->size_f_ == sizeof(F));
+            Expects(m_.size() >= bytes(static_cast<size_t>(h_->capacity)));
+
+            return shared(std::move(m_));
+        }
+
+        size_t capacity() const noexcept
+        {
+            return static_cast<size_t>(h->capacity);
+        }
+        // number of completed publications
+        uint64_t version() const noexcept
+        {
+            return h->seq.load(std::memory_order_acquire) / 2;
+        }
+
+        // Write a new curve. Only one process may publish.
+        void publish(size_t n, const T* t_, const F* f_, const F& _f = std::numeric_limits<F>::quiet_NaN())
+        {
+            Expects(n <= capacity());
+
+            auto s = h->seq.load(std::memory_order_relaxed);
+            h->seq.store(s + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            std::copy(t_, t_ + n, t);
+            std::copy(f_, f_ + n, f);
+            cumulative(n, t, f, I);
+            h->_f = _f;
+            h->n.store(n, std::memory_order_relaxed);
+
+            h->seq.store(s + 2, std::memory_order_release);
+        }
+
+        // Call op(view) on the mapped curve and return its result.
+        // The result is discarded and op called again if a write overlapped the read.
+        template<class Op>
+        auto read(Op op) const
+        {
+            for (;;) {
+                auto s = h->seq.load(std::memory_order_acquire);
+                if (s & 1)
+                    continue;
+
+                auto n = static_cast<size_t>(h->n.load(std::memory_order_relaxed));
+                auto r = op(view<T, F>{ n, t, f, I, h->_f });
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (h->seq.load(std::memory_order_relaxed) == s)
+                    return r;
+            }
+        }
+    };
+
+} // fms::pwflat
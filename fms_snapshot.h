@@ -0,0 +1,135 @@
+// fms_snapshot.h - Binary file of curves that is mapped and used without parsing.
+// Layout: header, entry[count], then t, f and I arrays for each curve.
+// Every section starts on a 64 byte boundary and offsets are from the start of the file.
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <gsl/gsl>
+#include "fms_curve.h"
+#include "fms_mmap.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class snapshot {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<F>);
+
+        static constexpr uint64_t MAGIC = 0x504e535f4359534d; // "MSYC_SNP"
+        static constexpr uint32_t VERSION = 1;
+        static constexpr size_t NAME = 32;
+
+        struct header {
+            uint64_t magic;
+            uint32_t version;
+            uint16_t size_t_; // sizeof(T)
+            uint16_t size_f_; // sizeof(F)
+            uint64_t count;   // number of curves
+            uint64_t bytes;   // file size
+            T as_of;          // valuation time of all curves
+        };
+        struct entry {
+            uint64_t n;
+            uint64_t t, f, I; // array offsets
+            F _f;
+            char name[NAME];  // null terminated
+        };
+
+        static constexpr size_t align(size_t n) noexcept
+        {
+            return (n + 63) & ~size_t(63);
+        }
+
+        mapping m;
+        const header* h;
+        const entry* e;
+
+        template<class X>
+        const X* at(uint64_t offset) const noexcept
+        {
+            return reinterpret_cast<const X*>(static_cast<const char*>(m.data()) + static_cast<size_t>(offset));
+        }
+    public:
+        // Write curves v[i] with optional names to path.
+        static void write(const char* path, size_t count, const view<T, F>* v,
+            const char* const* name = nullptr, T as_of = 0)
+        {
+            size_t off = align(sizeof(header)) + align(count * sizeof(entry));
+            std::vector<entry> e_(count);
+            for (size_t i = 0; i < count; ++i) {
+                e_[i].n = v[i].n;
+                e_[i].t = off;
+                off += align(v[i].n * sizeof(T));
+                e_[i].f = off;
+                off += align(v[i].n * sizeof(F));
+                e_[i].I = off;
+                off += align(v[i].n * sizeof(F));
+                e_[i]._f = v[i]._f;
+                if (name && name[i]) {
+                    Expects(strlen(name[i]) < NAME);
+                    memcpy(e_[i].name, name[i], strlen(name[i]));
+                }
+            }
+
+            header h_{ MAGIC, VERSION, sizeof(T), sizeof(F), count, off, as_of };
+            std::vector<char> buf(off);
+            memcpy(buf.data(), &h_, sizeof(h_));
+            memcpy(buf.data() + align(sizeof(header)), e_.data(), count * sizeof(entry));
+            for (size_t i = 0; i < count; ++i) {
+                memcpy(buf.data() + e_[i].t, v[i].t, v[i].n * sizeof(T));
+                memcpy(buf.data() + e_[i].f, v[i].f, v[i].n * sizeof(F));
+                memcpy(buf.data() + e_[i].I, v[i].I, v[i].n * sizeof(F));
+            }
+
+            std::ofstream os(path, std::ios::binary | std::ios::trunc);
+            os.write(buf.data(), buf.size());
+            if (!os)
+                throw std::system_error(errno, std::generic_category(), path);
+        }
+
+        // Map the file at path.
+        explicit snapshot(const char* path)
+            : m(mapping::file(path)), h(at<header>(0)), e(at<entry>(align(sizeof(header))))
+        {
+            Expects(m.size() >= sizeof(header));
+            Expects(h->magic == MAGIC && h->version == VERSION);
+            Expects(h->size_t_ == sizeof(T) && h->size_f_ == sizeof(F));
+            Expects(h->bytes == m.size());
+        }
+
+        size_t size() const noexcept
+        {
+            return static_cast<size_t>(h->count);
+        }
+        T as_of() const noexcept
+        {
+            return h->as_of;
+        }
+        std::string_view name(size_t i) const noexcept
+        {
+            return std::string_view(e[i].name, strnlen(e[i].name, NAME));
+        }
+        // curve i as it lies in the mapped file
+        view<T, F> operator[](size_t i) const noexcept
+        {
+            const entry& ei = e[i];
+
+            return view<T, F>{ static_cast<size_t>(ei.n), at<T>(ei.t), at<F>(ei.f), at<F>(ei.I), ei._f };
+        }
+        // index of curve with name or size() if not found
+        size_t find(std::string_view name_) const noexcept
+        {
+            size_t i = 0;
+            while (i < size() && name(i) != name_)
+                ++i;
+
+            return i;
+        }
+    };
+
+} // fms::pwflat
@@ -0,0 +1,101 @@
+// fms_spread.h - Implied parallel shifts (z-spreads) for many instruments at once.
+// With w = c D(u) cached per cash flow the present value at spread s is
+// sum w exp(-s u), so each Newton step needs one exp per cash flow and no curve lookups.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "fms_portfolio.h"
+
+namespace fms::pwflat {
+
+    // Solve sum_i w[i] exp(-s u[i]) = p for s starting from s. Newton steps are taken
+    // on log V(s) - log p, which is convex for positive w so steps stay bounded,
+    // and steps that leave the bracket found so far are replaced by bisection.
+    // Return the number of steps taken or iter + 1 if not converged, in which case s is NaN.
+    template<class T, class F>
+    inline size_t implied(size_t m, const T* u, const F* w, const F& p, F& s,
+        const F& tol = F(1e-12), size_t iter = 100) noexcept
+    {
+        constexpr F inf = std::numeric_limits<F>::infinity();
+        F lo = -inf, hi = inf; // value is decreasing in s for positive w
+
+        for (size_t j = 1; j <= iter; ++j) {
+            F V{ 0 }, dV{ 0 };
+            for (size_t i = 0; i < m; ++i) {
+                F x = w[i] * exp(-s * u[i]);
+                V += x;
+                dV -= u[i] * x;
+            }
+            if (V > p)
+                lo = s;
+            else
+                hi = s;
+
+            F ds = V > 0 && p > 0 ? log(V / p) * V / dV : (V - p) / dV;
+            if (fabs(ds) <= tol) {
+                s -= ds;
+
+                return j;
+            }
+            s -= ds;
+            if (!(lo < s && s < hi) && std::isfinite(lo) && std::isfinite(hi))
+                s = (lo + hi) / 2;
+        }
+        s = std::numeric_limits<F>::quiet_NaN();
+
+        return iter + 1;
+    }
+
+    // iteration counts of a batch solve
+    struct solve_stats {
+        size_t converged = 0;
+        size_t steps = 0;      // total over converged instruments
+        size_t max_steps = 0;  // maximum over converged instruments
+    };
+
+    // Solve sum_i w[i] exp(-s[k] u[i]) = p[k] over the cash flows of each instrument k
+    // starting from s[k] using p_ threads. Instruments not converged get NaN.
+    template<class T, class F>
+    inline solve_stats implied(const portfolio<T, F>& pf, const F* w, const F* p, F* s,
+        const F& tol = F(1e-12), size_t iter = 100, size_t p_ = 0)
+    {
+        p_ = threads(p_);
+        auto b = partition(pf.size(), [&pf](size_t k) { return pf.size(k); }, 16 * p_);
+        std::vector<size_t> steps(pf.size());
+
+        work_steal(b.size() - 1, [&](size_t j) {
+            for (size_t k = b[j]; k < b[j + 1]; ++k)
+                steps[k] = implied(pf.size(k), pf.time(k), w + pf.offset(k), p[k], s[k], tol, iter);
+        }, p_);
+
+        solve_stats stats;
+        for (size_t n : steps) {
+            if (n <= iter) {
+                ++stats.converged;
+                stats.steps += n;
+                stats.max_steps = std::max(stats.max_steps, n);
+            }
+        }
+
+        return stats;
+    }
+
+    // z-spread s[k] over the curve matching price p[k] for each instrument k
+    template<class T, class F>
+    inline solve_stats spreads(const portfolio<T, F>& pf, const F* p, F* s,
+        size_t n, const T* t, const F* f, const F& _f = std::numeric_limits<F>::quiet_NaN(),
+        const F& tol = F(1e-12), size_t iter = 100, size_t p_ = 0)
+    {
+        curve<T, F> c(n, t, f, _f);
+        std::vector<F> w(pf.cash_flows());
+        for (size_t k = 0; k < pf.size(); ++k) {
+            for (size_t i = 0; i < pf.size(k); ++i)
+                w[pf.offset(k) + i] = pf.cash(k)[i] * c.discount(pf.time(k)[i]);
+        }
+
+        return implied(pf, w.data(), p, s, tol, iter, p_);
+    }
+
+} // fms::pwflat
@@ -0,0 +1,87 @@
+// fms_store.h - Many curves packed into contiguous arrays.
+// Curve k has times t[off[k]], ..., t[off[k+1] - 1] and likewise for f and I,
+// so evaluating many curves walks memory instead of chasing separate allocations.
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "fms_curve.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class store {
+        std::vector<T> t;
+        std::vector<F> f, I, _f;
+        std::vector<size_t> off;
+    public:
+        store()
+            : off{ 0 }
+        { }
+
+        void reserve(size_t curves, size_t times)
+        {
+            t.reserve(times);
+            f.reserve(times);
+            I.reserve(times);
+            _f.reserve(curves);
+            off.reserve(curves + 1);
+        }
+
+        // number of curves
+        size_t size() const noexcept
+        {
+            return _f.size();
+        }
+
+        // Append a curve and return its index. Invalidates views.
+        size_t add(size_t n, const T* t_, const F* f_, const F& _f_ = std::numeric_limits<F>::quiet_NaN())
+        {
+            size_t k = off.back();
+            t.insert(t.end(), t_, t_ + n);
+            f.insert(f.end(), f_, f_ + n);
+            I.resize(k + n);
+            cumulative(n, t_, f_, I.data() + k);
+            _f.push_back(_f_);
+            off.push_back(k + n);
+
+            return size() - 1;
+        }
+
+        view<T, F> operator[](size_t k) const noexcept
+        {
+            size_t i = off[k];
+
+            return view<T, F>{ off[k + 1] - i, t.data() + i, f.data() + i, I.data() + i, _f[k] };
+        }
+
+        // I[j] = int_0^u f_k(t) dt for curves k = id[j], j < m
+        void integral(const T& u, size_t m, const size_t* id, F* I_) const noexcept
+        {
+            for (size_t j = 0; j < m; ++j)
+                I_[j] = operator[](id[j]).integral(u);
+        }
+        // I[k] = int_0^u f_k(t) dt for all curves
+        void integral(const T& u, F* I_) const noexcept
+        {
+            for (size_t k = 0; k < size(); ++k)
+                I_[k] = operator[](k).integral(u);
+        }
+
+        // D[j] = D_k(u) for curves k = id[j], j < m
+        void discount(const T& u, size_t m, const size_t* id, F* D) const noexcept
+        {
+            integral(u, m, id, D);
+            for (size_t j = 0; j < m; ++j)
+                D[j] = exp(-D[j]);
+        }
+        // D[k] = D_k(u) for all curves
+        void discount(const T& u, F* D) const noexcept
+        {
+            integral(u, D);
+            for (size_t k = 0; k < size(); ++k)
+                D[k] = exp(-D[k]);
+        }
+    };
+
+} // fms::pwflat
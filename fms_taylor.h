@@ -0,0 +1,127 @@
+// fms_taylor.h - Second order approximation of present value under forward curve changes.
+// With forward changes df[j] on segment j, where j = n is the extrapolation,
+// pv(f + df) ~ pv + g.df + df.H.df/2 with g and H computed once per instrument.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "fms_pwflat.h"
+
+namespace fms::pwflat {
+
+    template<class T = double, class F = double>
+    class taylor {
+        size_t n;
+        std::vector<T> t, u;
+        std::vector<F> f, c, I; // I[j] = int_0^t[j] f(t) dt
+        F _f;
+        F pv;
+        std::vector<F> g, H; // gradient and (n+1) x (n+1) Hessian
+        F A, U;              // sum |c| D u^3 and max u for the error bound
+    public:
+        taylor(size_t m, const T* u_, const F* c_, size_t n_, const T* t_, const F* f_,
+            const F& _f_ = std::numeric_limits<F>::quiet_NaN())
+            : n(n_), t(t_, t_ + n_), u(u_, u_ + m), f(f_, f_ + n_), c(c_, c_ + m), I(n_), _f(_f_),
+            pv(0), g(n_ + 1), H((n_ + 1) * (n_ + 1)), A(0), U(0)
+        {
+            cumulative(n, t.data(), f.data(), I.data());
+            std::vector<F> tau(n + 1);
+            for (size_t i = 0; i < m; ++i) {
+                F cD = c[i] * pwflat::discount(u[i], n, t.data(), f.data(), I.data(), _f);
+                for (size_t j = 0; j <= n; ++j)
+                    tau[j] = overlap(j, u[i], n, t.data());
+                for (size_t j = 0; j <= n; ++j) {
+                    if (tau[j] == 0)
+                        continue;
+                    g[j] -= tau[j] * cD;
+                    for (size_t k = 0; k <= n; ++k)
+                        H[j * (n + 1) + k] += tau[j] * tau[k] * cD;
+                }
+                pv += cD;
+                A += fabs(cD) * u[i] * u[i] * u[i];
+                U = std::max(U, static_cast<F>(u[i]));
+            }
+        }
+
+        // number of forwards including the extrapolation
+        size_t size() const noexcept
+        {
+            return n + 1;
+        }
+        F value() const noexcept
+        {
+            return pv;
+        }
+        const F* gradient() const noexcept
+        {
+            return g.data();
+        }
+        const F* hessian() const noexcept
+        {
+            return H.data();
+        }
+
+        // Bound on the error of the approximation for changes df.
+        // |exp(-x) - (1 - x + x^2/2)| <= |x|^3 exp(|x|)/6 and |x| <= u max|df|.
+        F error(const F* df) const noexcept
+        {
+            F d{ 0 };
+
+            for (size_t j = 0; j <= n; ++j)
+                d = std::max(d, static_cast<F>(fabs(df[j])));
+
+            return A * d * d * d * exp(U * d) / 6;
+        }
+
+        // second order approximation of present value with forward changes df[j]
+        F approximate(const F* df) const noexcept
+        {
+            F p = pv;
+
+            for (size_t j = 0; j <= n; ++j) {
+                if (df[j] == 0)
+                    continue;
+                F Hdf{ 0 };
+                for (size_t k = 0; k <= n; ++k)
+                    Hdf += H[j * (n + 1) + k] * df[k];
+                p += df[j] * (g[j] + Hdf / 2);
+            }
+
+            return p;
+        }
+
+        // full repricing with forward changes df[j]
+        F exact(const F* df) const
+        {
+            std::vector<F> f_(n), I_(n);
+            for (size_t j = 0; j < n; ++j)
+                f_[j] = f[j] + df[j];
+            cumulative(n, t.data(), f_.data(), I_.data());
+
+            F p{ 0 };
+            for (size_t i = 0; i < u.size(); ++i)
+                p += c[i] * pwflat::discount(u[i], n, t.data(), f_.data(), I_.data(), _f + df[n]);
+
+            return p;
+        }
+
+        // approximate present value, or exact if the error bound exceeds tol
+        F present_value(const F* df, const F& tol, F* err = nullptr) const
+        {
+            F e = error(df);
+            if (err)
+                *err = e;
+
+            return e <= tol ? approximate(df) : exact(df);
+        }
+
+        // pv[s] for scenarios df[s*(n+1) + j], s < k, and optional error bounds err[s]
+        void present_value(size_t k, const F* df, const F& tol, F* pv_, F* err = nullptr) const
+        {
+            for (size_t s = 0; s < k; ++s)
+                pv_[s] = present_value(df + s * (n + 1), tol, err ? err + s : nullptr);
+        }
+    };
+
+} // fms::pwflat
@@ -0,0 +1,100 @@
+// fms_var.h - Historical value at risk from daily forward curve changes.
+// Each day stores the change in today's forward on every segment, including the
+// extrapolation, so day d reprices the portfolio at f[j] + df[d][j].
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <gsl/gsl>
+#include "fms_curve.h"
+#include "fms_parallel.h"
+#include "fms_portfolio.h"
+
+namespace fms::pwflat {
+
+    // S is the storage type of the daily changes
+    template<class T = double, class F = double, class S = float>
+    class historical {
+        curve<T, F> today;
+        std::vector<S> df; // df[d*(n+1) + j]
+    public:
+        historical(curve<T, F> today_)
+            : today(std::move(today_))
+        { }
+
+        // number of forwards including the extrapolation
+        size_t width() const noexcept
+        {
+            return today.size() + 1;
+        }
+        // number of days
+        size_t size() const noexcept
+        {
+            return df.size() / width();
+        }
+        const S* change(size_t d) const noexcept
+        {
+            return df.data() + d * width();
+        }
+
+        // add forward changes df_[j], j <= n
+        void add(const F* df_)
+        {
+            for (size_t j = 0; j < width(); ++j)
+                df.push_back(static_cast<S>(df_[j]));
+        }
+        // add the change from curve c0 to curve c1 on the segments of today's curve
+        void add(const curve<T, F>& c0, const curve<T, F>& c1)
+        {
+            size_t n = today.size();
+            for (size_t j = 0; j < n; ++j) {
+                T u = today.time()[j];
+                df.push_back(static_cast<S>(c1.value(u) - c0.value(u)));
+            }
+            F _d = c1.extrapolate() - c0.extrapolate();
+            df.push_back(static_cast<S>(std::isnan(_d) ? 0 : _d));
+        }
+
+        // Profit and loss pnl[d] of the portfolio on each day using p threads.
+        // Each day is summed in instrument order so results do not depend on p.
+        void pnl(const portfolio<T, F>& pf, F* pnl_, size_t p = 0) const
+        {
+            size_t n = today.size();
+            F pv = pf.total(today.view());
+
+            parallel_for(size(), [&](size_t d) {
+                const S* dd = change(d);
+                std::vector<F> f(n);
+                for (size_t j = 0; j < n; ++j)
+                    f[j] = today.forward()[j] + dd[j];
+                curve<T, F> c(n, today.time(), f.data(), today.extrapolate() + dd[n]);
+                pnl_[d] = pf.total(c.view()) - pv;
+            }, p);
+        }
+    };
+
+    // quantile of x[0], ..., x[m-1] interpolating between order statistics
+    template<class F>
+    inline F quantile(F q, size_t m, const F* x)
+    {
+        Expects(m > 0 && 0 <= q && q <= 1);
+
+        std::vector<F> y(x, x + m);
+        std::sort(y.begin(), y.end());
+        F i = q * (m - 1);
+        size_t i0 = static_cast<size_t>(i);
+        if (i0 + 1 >= m)
+            return y[m - 1];
+
+        return y[i0] + (i - i0) * (y[i0 + 1] - y[i0]);
+    }
+
+    // value at risk at confidence level a as a positive loss
+    template<class F>
+    inline F value_at_risk(F a, size_t m, const F* pnl)
+    {
+        return -quantile(1 - a, m, pnl);
+    }
+
+} // fms::pwflat
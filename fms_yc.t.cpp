@@ -1,7 +1,33 @@
 // fms_yc.t.cpp - Test yield curve code
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
 #include <vector>
 #include "fms_pwflat.h"
+#include "fms_publish.h"
+#include "fms_shm.h"
+#include "fms_snapshot.h"
+#include "fms_store.h"
+#include "fms_family.h"
+#include "fms_scenario.h"
+#include "fms_shift.h"
+#include "fms_taylor.h"
+#include "fms_var.h"
+#include "fms_netting.h"
+#include "fms_csr.h"
+#include "fms_incremental.h"
+#include "fms_aggregate.h"
+#include "fms_grid.h"
+#include "fms_profile.h"
+#include "fms_forward.h"
+#include "fms_par.h"
+#include "fms_spread.h"
+#include "fms_yield.h"
+#include "fms_credit.h"
+#include "fms_composite.h"
+#include "fms_bump.h"
+#include "fms_roll.h"
 
 template<class T>
 void test_fms_pwflat()
@@ -84,6 +110,12 @@ void test_fms_pwflat()
         u = 3;
         assert(fabs(T(.1) + T(.2) + T(.3) - integral(u, t.size(), t.data(), f.data())) < 2 * eps);
         //		assert (.1 + .2 + .3 != .6); 
+
+        // f[n] is never read at u == t[n-1]
+        T g[] = { T(.1), T(.2), std::numeric_limits<T>::quiet_NaN() };
+        u = 2;
+        assert(T(.1) + T(.2) == integral(u, 2, t.data(), g));
+        assert(T(.1) + T(.2) == integral(u, 2, t.data(), g, T(.3)));
     }
     { // discount
         T u_[] = { T(-.5), T(0), T(.5), T(1), T(1.5), T(2), T(2.5), T(3), T(3.5) };
@@ -146,10 +178,910 @@ void test_fms_pwflat()
 
     }
 }
+
+void test_fms_publish()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    published<> pub(curve<>(3, t, f));
+    {
+        auto r = pub.register_reader();
+        auto p = r.read();
+        assert(p->discount(1.5) == discount(1.5, 3, t, f));
+        double g[] = { .2, .4, .6 };
+        pub.publish(curve<>(3, t, g));
+        // old snapshot is unchanged while pinned
+        assert(p->discount(1.5) == discount(1.5, 3, t, f));
+        assert(pub.pending() == 1);
+        assert(r.read()->discount(1.5) == discount(1.5, 3, t, g));
+    }
+    assert(pub.pending() == 0);
+
+    // an inner pin ending does not unpin the outer one
+    {
+        auto r = pub.register_reader();
+        auto p = r.read();
+        double d = p->discount(1.5);
+        {
+            auto q = r.read();
+            assert(q->discount(1.5) == d);
+        }
+        double g[] = { .3, .6, .9 };
+        pub.publish(curve<>(3, t, g));
+        assert(pub.pending() == 1);
+        assert(p->discount(1.5) == d);
+    }
+    assert(pub.pending() == 0);
+
+    // readers never see a torn curve while a writer republishes
+    std::atomic<bool> done{ false };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&pub, &done]() {
+            auto r = pub.register_reader();
+            while (!done) {
+                auto p = r.read();
+                assert(p->size() == 3);
+                assert(p->forward()[1] == 2 * p->forward()[0]);
+            }
+        });
+    }
+    for (int i = 1; i <= 1000; ++i) {
+        double g[] = { i / 1024., i / 512., i / 256. };
+        pub.publish(curve<>(3, t, g));
+    }
+    done = true;
+    for (auto& r : readers)
+        r.join();
+    assert(pub.pending() == 0);
+}
+
+
+void test_fms_shm()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    const char* name = "/fms_yc_t_shm";
+    auto builder = shared<>::create(name, 8);
+    assert(builder.capacity() == 8);
+    builder.publish(3, t, f, .4);
+    assert(builder.version() == 1);
+
+    auto worker = shared<>::open(name);
+    for (double u : { 0., .5, 1., 2.5, 3.5 }) {
+        auto D = worker.read([u](const view<>& v) { return v.discount(u); });
+        assert(fabs(D - discount(u, 3, t, f, .4)) < 1e-15);
+    }
+    double u[] = { 1, 2, 4 }, c[] = { 1, 1, 1 };
+    assert(worker.read([&](const view<>& v) { return v.present_value(3, u, c); })
+        == curve<>(3, t, f, .4).present_value(3, u, c));
+
+    fms::mapping::unlink(name);
+}
+
+
+void test_fms_snapshot()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 }, g[] = { .05 };
+    curve<> c[] = { curve<>(3, t, f, .4), curve<>(1, t, g) };
+    view<> v[] = { c[0].view(), c[1].view() };
+    const char* name[] = { "USD-SOFR", "EUR-ESTR" };
+    const char* path = "fms_yc_t.snapshot";
+    snapshot<>::write(path, 2, v, name, 0.5);
+    {
+        snapshot<> s(path);
+        assert(s.size() == 2);
+        assert(s.as_of() == 0.5);
+        assert(s.find("EUR-ESTR") == 1);
+        assert(s.find("GBP-SONIA") == 2);
+        auto s0 = s[0];
+        assert(s0.n == 3 && s0.t[2] == 3 && s0.I[2] == c[0].integral(3));
+        double u[] = { .5, 1.5, 2.5, 3.5 }, cf[] = { 1, 1, 1, 1 };
+        assert(s0.present_value(4, u, cf) == c[0].present_value(4, u, cf));
+        assert(present_value(3, u, cf, s0.n, s0.t, s0.f) == present_value(3, u, cf, 3, t, f));
+        assert(s[1].discount(.5) == c[1].discount(.5));
+        assert(reinterpret_cast<uintptr_t>(s[1].t) % 64 == 0);
+    }
+    std::remove(path);
+}
+
+
+void test_fms_store()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 }, g[] = { .3, .2, .1 };
+    store<> s;
+    s.reserve(3, 7);
+    assert(s.add(3, t, f, .4) == 0);
+    assert(s.add(1, t, g) == 1);
+    assert(s.add(3, t, g, .1) == 2);
+    assert(s.size() == 3);
+    assert(s[1].n == 1 && s[2].f[0] == .3);
+
+    double D[3];
+    s.discount(.5, D);
+    assert(D[0] == discount(.5, 3, t, f, .4));
+    assert(D[1] == discount(.5, 1, t, g));
+    assert(D[2] == discount(.5, 3, t, g, .1));
+
+    size_t id[] = { 2, 0 };
+    s.discount(2.5, 2, id, D);
+    assert(fabs(D[0] - discount(2.5, 3, t, g, .1)) < 1e-15);
+    assert(fabs(D[1] - discount(2.5, 3, t, f, .4)) < 1e-15);
+}
+
+
+void test_fms_family()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 };
+    double f[] = { .1, .2, .3,  .3, .2, .1 }, _f[] = { .4, .05 };
+    family<> fam(3, t, 2, f, _f);
+    assert(fam.size() == 2 && fam.times() == 3);
+
+    double v[2], D[2];
+    for (double u : { 0., .5, 1., 1.5, 2.5, 3.5 }) {
+        fam.value(u, v);
+        assert(v[0] == value(u, 3, t, f, _f[0]));
+        assert(v[1] == value(u, 3, t, f + 3, _f[1]));
+        fam.discount(u, D);
+        assert(fabs(D[0] - discount(u, 3, t, f, _f[0])) < 1e-15);
+        assert(fabs(D[1] - discount(u, 3, t, f + 3, _f[1])) < 1e-15);
+    }
+    fam.value(-1, v);
+    assert(isnan(v[0]) && isnan(v[1]));
+
+    double u[] = { .5, 1.5, 3.5 }, c[] = { 1, 2, 3 }, pv[2];
+    fam.present_value(3, u, c, pv, D);
+    assert(fabs(pv[0] - present_value(3, u, c, 3, t, f, _f[0])) < 1e-14);
+    assert(fabs(pv[1] - present_value(3, u, c, 3, t, f + 3, _f[1])) < 1e-14);
+}
+
+
+void test_fms_scenario()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    scenarios<> s(curve<>(3, t, f, .4));
+    size_t i0[] = { 1 }, i1[] = { 0, 3 };
+    double d0[] = { .01 }, d1[] = { -.02, .05 };
+    assert(s.add(1, i0, d0) == 0);
+    assert(s.add(2, i1, d1) == 1);
+    assert(s.add(0, nullptr, nullptr) == 2);
+
+    double f0[] = { .1, .21, .3 }, f1[] = { .08, .2, .3 };
+    double D[3];
+    for (double u : { .5, 1.5, 2.5, 3.5 }) {
+        assert(fabs(s.discount(0, u) - discount(u, 3, t, f0, .4)) < 1e-15);
+        assert(fabs(s.discount(1, u) - discount(u, 3, t, f1, .45)) < 1e-15);
+        s.discount(u, D);
+        assert(D[0] == s.discount(0, u) && D[1] == s.discount(1, u));
+        assert(D[2] == s.base().discount(u));
+    }
+
+    double u[] = { .5, 1.5, 3.5 }, c[] = { 1, 2, 3 }, pv[3];
+    s.present_value(3, u, c, pv);
+    assert(fabs(pv[1] - present_value(3, u, c, 3, t, f1, .45)) < 1e-14);
+    assert(fabs(pv[1] - s.present_value(1, 3, u, c)) < 1e-14);
+}
+
+
+void test_fms_shift()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    double u[] = { .5, 1.5, 2.5, 3.5 }, c[] = { .05, .05, .05, 1.05 };
+    shift<> s(4, u, c, 3, t, f, .4);
+    assert(s.size() == 4);
+    assert(fabs(s.present_value() - present_value(4, u, c, 3, t, f, .4)) < 1e-15);
+    assert(fabs(s.duration() - duration(4, u, c, 3, t, f, .4)) < 1e-15);
+
+    double a[] = { -.01, 0, .01 }, pv[3];
+    s.present_value(3, a, pv);
+    for (int j = 0; j < 3; ++j) {
+        double g[] = { .1 + a[j], .2 + a[j], .3 + a[j] };
+        assert(fabs(pv[j] - present_value(4, u, c, 3, t, g, .4 + a[j])) < 1e-14);
+    }
+
+    // twist of .01 about 2: a = -.02, b = .01
+    double a_[] = { -.02 }, b_[] = { .01 };
+    s.present_value(1, a_, b_, pv);
+    double p = 0;
+    for (int i = 0; i < 4; ++i)
+        p += c[i] * discount(u[i], 3, t, f, .4) * exp(-(-.02 * u[i] + .01 * u[i] * u[i] / 2));
+    assert(fabs(pv[0] - p) < 1e-14);
+}
+
+
+void test_fms_taylor()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    double u[] = { .5, 1.5, 2.5, 3.5 }, c[] = { .05, .05, .05, 1.05 };
+    taylor<> tp(4, u, c, 3, t, f, .4);
+    assert(tp.size() == 4);
+    assert(fabs(tp.value() - present_value(4, u, c, 3, t, f, .4)) < 1e-15);
+
+    double d[4], I[3];
+    cumulative(3, t, f, I);
+    key_rate(4, u, c, 3, t, f, I, d, .4);
+    for (int j = 0; j < 4; ++j)
+        assert(fabs(d[j] - tp.gradient()[j]) < 1e-15);
+    double dur = d[0] + d[1] + d[2] + d[3];
+    assert(fabs(dur - duration(4, u, c, 3, t, f, .4)) < 1e-14);
+
+    // cash flow on the last knot
+    double u3[] = { 1, 3 };
+    key_rate(2, u3, c + 2, 3, t, f, I, d, .4);
+    assert(d[3] == 0);
+    assert(fabs(d[0] + d[1] + d[2] - duration(2, u3, c + 2, 3, t, f, .4)) < 1e-14);
+    taylor<> t3(2, u3, c + 2, 3, t, f);
+    assert(fabs(t3.value() - present_value(2, u3, c + 2, 3, t, f)) < 1e-15);
+
+    double df[] = { .001, -.002, .0005, .001,  .1, .1, .1, .1 }, pv[2], err[2];
+    double exact = tp.exact(df);
+    double approx = tp.approximate(df);
+    assert(fabs(exact - approx) <= tp.error(df));
+    assert(tp.error(df) < 1e-6);
+
+    tp.present_value(2, df, 1e-6, pv, err);
+    assert(pv[0] == approx);
+    assert(err[1] > 1e-6);
+    assert(pv[1] == tp.exact(df + 4));
+}
+
+
+void test_fms_var()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    portfolio<> pf;
+    double u0[] = { .5, 1.5, 2.5, 3.5 }, c0[] = { .05, .05, .05, 1.05 };
+    double u1[] = { 2 }, c1[] = { -1 };
+    assert(pf.add(4, u0, c0) == 0);
+    assert(pf.add(1, u1, c1) == 1);
+    assert(pf.size() == 2 && pf.cash_flows() == 5 && pf.size(0) == 4);
+    assert(pf.total(3, t, f, .4) == pf.present_value(0, 3, t, f, .4) + pf.present_value(1, 3, t, f, .4));
+
+    curve<> c(3, t, f, .4);
+    historical<> h(c);
+    assert(h.width() == 4);
+    double g[] = { .11, .19, .3 };
+    h.add(c, curve<>(3, t, g, .41));
+    for (int d = 1; d < 100; ++d) {
+        double df[] = { d * 1e-4, -d * 1e-4, (d % 7) * 1e-4, (d % 3) * 1e-4 };
+        h.add(df);
+    }
+    assert(h.size() == 100);
+    assert(fabs(h.change(0)[0] - .01) < 1e-7 && fabs(h.change(0)[3] - .01) < 1e-7);
+
+    std::vector<double> pnl(h.size()), pnl1(h.size());
+    h.pnl(pf, pnl.data());
+    h.pnl(pf, pnl1.data(), 1);
+    assert(pnl == pnl1);
+    double f_[] = { .1 + h.change(5)[0], .2 + h.change(5)[1], .3 + h.change(5)[2] };
+    assert(fabs(pnl[5] - (pf.total(3, t, f_, .4 + h.change(5)[3]) - pf.total(3, t, f, .4))) < 1e-15);
+
+    double x[] = { 3, 1, 2, 5, 4 };
+    assert(quantile(0., 5, x) == 1);
+    assert(quantile(.5, 5, x) == 3);
+    assert(quantile(.125, 5, x) == 1.5);
+    assert(quantile(1., 5, x) == 5);
+    assert(value_at_risk(.99, h.size(), pnl.data()) > 0);
+}
+
+
+void test_fms_work_steal()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    curve<> c(3, t, f, .4);
+    portfolio<> pf;
+    std::vector<double> u, cf;
+    for (size_t k = 0; k < 1000; ++k) {
+        size_t m = 1 + (k * k) % 97;
+        u.resize(m);
+        cf.resize(m);
+        for (size_t i = 0; i < m; ++i) {
+            u[i] = (i + 1) * .25;
+            cf[i] = i + 1 == m ? 1 : .01;
+        }
+        pf.add(m, u.data(), cf.data());
+    }
+
+    std::vector<double> pv(pf.size());
+    pf.present_value(c.view(), pv.data(), 8);
+    for (size_t k = 0; k < pf.size(); ++k)
+        assert(pv[k] == pf.present_value(k, c.view()));
+
+    size_t w[] = { 1, 1, 1, 10, 1, 1, 1, 1 };
+    auto b = fms::partition(8, [&w](size_t i) { return w[i]; }, 4);
+    assert(b.front() == 0 && b.back() == 8);
+    assert((b == std::vector<size_t>{ 0, 4, 8 }));
+    assert(fms::partition(0, [&w](size_t i) { return w[i]; }, 4).size() == 1);
+
+    std::vector<std::atomic<int>> hit(10000);
+    fms::work_steal(hit.size(), [&hit](size_t i) { ++hit[i]; }, 8);
+    for (auto& h : hit)
+        assert(h == 1);
+}
+
+
+void test_fms_sum()
+{
+    using namespace fms::pwflat;
+
+    double x[] = { 1e16, 1, -1e16, 1 };
+    assert(fms::pairwise(4, x) == (1e16 + 1) + (-1e16 + 1));
+    assert(fms::pairwise(0, x) == 0);
+
+    std::vector<double> y(100000);
+    for (size_t i = 0; i < y.size(); ++i)
+        y[i] = 1. / (i + 1) * (i % 2 ? -1 : 1);
+    auto s1 = fms::sum<double>(y.size(), [&y](size_t i) { return y[i]; }, 1);
+    for (size_t p : { 2, 3, 7, 16 })
+        assert(s1 == fms::sum<double>(y.size(), [&y](size_t i) { return y[i]; }, p));
+    assert(fabs(s1 - log(2.)) < 1e-4);
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    curve<> c(3, t, f, .4);
+    portfolio<> pf;
+    for (size_t k = 0; k < 5000; ++k) {
+        double u[] = { .5 + k % 3, 1.5 + k % 3 }, cf[] = { k * .001, 1 };
+        pf.add(2, u, cf);
+    }
+    double pv1 = pf.total(c.view(), 1);
+    assert(pv1 == pf.total(c.view(), 5));
+    assert(fabs(pv1 - pf.total(c.view())) < 1e-9);
+
+    double d1[4], d5[4];
+    pf.key_rate(c.view(), d1, 1);
+    pf.key_rate(c.view(), d5, 5);
+    double dur = 0;
+    for (int j = 0; j < 4; ++j) {
+        assert(d1[j] == d5[j]);
+        dur += d1[j];
+    }
+    double dur_ = 0;
+    for (size_t k = 0; k < pf.size(); ++k)
+        dur_ += duration(pf.size(k), pf.time(k), pf.cash(k), 3, t, f, .4);
+    assert(fabs(dur - dur_) < 1e-8);
+}
+
+
+void test_fms_netting()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 }, g[] = { .2, .2, .2 };
+    curve<> c0(3, t, f, .4), c1(3, t, g, .2);
+    portfolio<> pf;
+    double u0[] = { .5, 1, 1.5, 2 }, cf0[] = { 1, 2, 3, 4 };
+    double u1[] = { 1, 2 }, cf1[] = { -2, 1 };
+    pf.add(4, u0, cf0);
+    pf.add(2, u1, cf1);
+
+    ladder<> l;
+    l.add(1, pf);
+    l.add(0, 2, u1, cf1);
+    l.compress();
+    assert(l.curves() == 2);
+    assert(l.size(0) == 2 && l.size(1) == 4 && l.size() == 6);
+    assert(l.time(1)[1] == 1 && l.cash(1)[1] == 0);
+    assert(l.time(1)[3] == 2 && l.cash(1)[3] == 5);
+
+    assert(fabs(l.present_value(1, c1.view()) - pf.total(c1.view())) < 1e-15);
+    assert(fabs(l.present_value(0, c0.view()) - present_value(2, u1, cf1, 3, t, f, .4)) < 1e-15);
+    double dur = duration(4, u0, cf0, 3, t, g, .2) + duration(2, u1, cf1, 3, t, g, .2);
+    assert(fabs(l.duration(1, c1.view()) - dur) < 1e-14);
+    double d[4], d_[4] = { 0, 0, 0, 0 };
+    l.key_rate(1, c1.view(), d);
+    pf.key_rate(c1.view(), d_, 1);
+    for (int j = 0; j < 4; ++j)
+        assert(fabs(d[j] - d_[j]) < 1e-14);
+}
+
+
+void test_fms_csr()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    double u[] = { 0, .5, 1, 2.5, 3, 3.5 }, D[6];
+    discounts(6, u, D, 3, t, f, .4);
+    curve<> c(3, t, f, .4);
+    for (int i = 0; i < 6; ++i)
+        assert(fabs(D[i] - c.discount(u[i])) < 1e-15);
+
+    portfolio<> pf;
+    double u0[] = { .5, 1.5, 2.5, 3.5 }, c0[] = { .05, .05, .05, 1.05 };
+    double u1[] = { 1.5, 1.5, 2 }, c1[] = { 1, 1, -1 };
+    pf.add(4, u0, c0);
+    pf.add(3, u1, c1);
+    pf.add(0, nullptr, nullptr);
+    csr<> A(pf);
+    assert(A.rows() == 3 && A.cols() == 5 && A.nonzeros() == 6);
+
+    double pv[3], DA[5];
+    A.present_value(pv, DA, 3, t, f, .4, 2);
+    for (size_t k = 0; k < pf.size(); ++k)
+        assert(fabs(pv[k] - pf.present_value(k, c.view())) < 1e-15);
+
+    // scenario discounts by date from a curve family
+    double fs[] = { .1, .2, .3,  .2, .2, .2 }, _fs[] = { .4, .2 };
+    family<> fam(3, t, 2, fs, _fs);
+    std::vector<double> X(A.cols() * 2), Y(A.rows() * 2);
+    fam.discount(A.cols(), A.dates(), X.data());
+    A.multiply(2, X.data(), Y.data());
+    for (size_t k = 0; k < pf.size(); ++k) {
+        assert(fabs(Y[k * 2] - pv[k]) < 1e-15);
+        assert(fabs(Y[k * 2 + 1] - present_value(pf.size(k), pf.time(k), pf.cash(k), 3, t, fs + 3, .2)) < 1e-15);
+    }
+}
+
+
+void test_fms_incremental()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    portfolio<> pf;
+    double u0[] = { .5, 1.5, 2.5, 3.5 }, c0[] = { .05, .05, .05, 1.05 };
+    double u1[] = { .5, 1 }, c1[] = { 1, 1 };
+    double u2[] = { 1.5, 2 }, c2[] = { 1, -1 };
+    pf.add(4, u0, c0);
+    pf.add(2, u1, c1);
+    pf.add(2, u2, c2);
+
+    incremental<> inc(pf, curve<>(3, t, f, .4));
+    assert(fabs(inc.total() - pf.total(3, t, f, .4)) < 1e-15);
+
+    assert(inc.update(curve<>(3, t, f, .4)) == 0);
+    // only the extrapolation changes
+    assert(inc.update(curve<>(3, t, f, .5)) == 1);
+    assert(fabs(inc.total() - pf.total(3, t, f, .5)) < 1e-15);
+    // forwards from segment 2 on
+    double g[] = { .1, .2, .35 };
+    assert(first_change(inc.base(), curve<>(3, t, g, .5)) == 2);
+    assert(inc.update(curve<>(3, t, g, .5)) == 1);
+    // forwards from segment 1 on
+    double h[] = { .1, .25, .35 };
+    assert(inc.update(curve<>(3, t, h, .5)) == 2);
+    assert(fabs(inc.total() - pf.total(3, t, h, .5)) < 1e-15);
+    for (size_t k = 0; k < pf.size(); ++k)
+        assert(fabs(inc.present_value(k) - pf.present_value(k, 3, t, h, .5)) < 1e-15);
+    assert(inc.update(curve<>(3, t, f, .4)) == 2);
+    assert(fabs(inc.total() - pf.total(3, t, f, .4)) < 1e-15);
+}
+
+
+void test_fms_aggregate()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 }, g[] = { .2, .2, .2 };
+    double u0[] = { .5, 1.5, 2.5, 3.5 }, c0[] = { .05, .05, .05, 1.05 };
+    double u1[] = { 1.5, 2.5 }, c1[] = { 1, -1 };
+    aggregate<> a(curve<>(3, t, f, .4), 1);
+    a.insert(7, 4, u0, c0);
+    a.insert(9, 2, u1, c1);
+    assert(a.size() == 2);
+    double pv = present_value(4, u0, c0, 3, t, f, .4) + present_value(2, u1, c1, 3, t, f, .4);
+    double dur = duration(4, u0, c0, 3, t, f, .4) + duration(2, u1, c1, 3, t, f, .4);
+    assert(fabs(a.present_value() - pv) < 1e-15);
+    assert(fabs(a.duration() - dur) < 1e-14);
+    double kr = 0;
+    for (int j = 0; j < 4; ++j)
+        kr += a.key_rate()[j];
+    assert(fabs(kr - dur) < 1e-14);
+
+    a.remove(9);
+    assert(a.size() == 1);
+    assert(fabs(a.present_value() - present_value(4, u0, c0, 3, t, f, .4)) < 1e-15);
+
+    // same version keeps the old curve
+    a.update(curve<>(3, t, g, .2), 1);
+    assert(fabs(a.present_value() - present_value(4, u0, c0, 3, t, f, .4)) < 1e-15);
+    a.update(curve<>(3, t, g, .2), 2);
+    assert(a.version() == 2);
+    assert(fabs(a.present_value() - present_value(4, u0, c0, 3, t, g, .2)) < 1e-15);
+}
+
+
+void test_fms_grid()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    size_t g = 401;
+    std::vector<double> D(g), r(g), v(g);
+    grid(g, -.01, .01, D.data(), r.data(), v.data(), 3, t, f, .4);
+    assert(isnan(D[0]) && isnan(r[0]) && isnan(v[0]));
+    for (size_t k = 1; k < g; ++k) {
+        double u = -.01 + k * .01;
+        assert(fabs(D[k] - discount(u, 3, t, f, .4)) < 1e-13);
+        assert(v[k] == value(u, 3, t, f, .4));
+        if (u > 0)
+            assert(fabs(r[k] - integral(u, 3, t, f, .4) / u) < 1e-13);
+    }
+    assert(r[1] == .1);
+
+    double D2[3];
+    grid(3, .5, 1., D2, nullptr, nullptr, 3, t, f, .4);
+    assert(fabs(D2[2] - exp(-.45)) < 1e-15);
+}
+
+
+void test_fms_profile()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    double u[] = { .5, 1.5, 2.5, 3.5 }, c[] = { .05, .05, .05, 1.05 };
+    double s[] = { 0, .5, 1, 2.5, 3, 4 }, V[6];
+    profile(4, u, c, 6, s, V, 3, t, f, .4);
+    for (int j = 0; j < 6; ++j) {
+        double v = 0;
+        for (int i = 0; i < 4; ++i)
+            if (u[i] > s[j])
+                v += c[i] * discount(u[i], 3, t, f, .4);
+        assert(fabs(V[j] - v / discount(s[j], 3, t, f, .4)) < 1e-14);
+    }
+    assert(fabs(V[0] - present_value(4, u, c, 3, t, f, .4)) < 1e-15);
+    assert(V[5] == 0);
+
+    portfolio<> pf;
+    double u1[] = { 1, 2 }, c1[] = { 1, -1 };
+    pf.add(4, u, c);
+    pf.add(2, u1, c1);
+    double W[12];
+    profile(pf, 6, s, W, 3, t, f, .4);
+    for (int j = 0; j < 6; ++j)
+        assert(W[j] == V[j]);
+    double V1[6];
+    profile(2, u1, c1, 6, s, V1, 3, t, f, .4);
+    for (int j = 0; j < 6; ++j)
+        assert(W[6 + j] == V1[j]);
+}
+
+
+void test_fms_forward()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .1, .2, .3 };
+    double d[] = { 0, .5, 1, 1.5, 2, 2.5, 3, 3.5 }, D[7], r[7];
+    forwards(7, d, D, r, 3, t, f, .4);
+    for (int i = 0; i < 7; ++i) {
+        double D0 = discount(d[i], 3, t, f, .4), D1 = discount(d[i + 1], 3, t, f, .4);
+        assert(fabs(D[i] - D1 / D0) < 1e-15);
+        assert(fabs(r[i] - (D0 / D1 - 1) / .5) < 1e-14);
+    }
+
+    // overlapping periods with day count fractions
+    double s[] = { 0, .5, 1 }, u[] = { 1, 1.5, 3.5 }, a[] = { 1.01, 1.01, 2.52 }, D_[3], r_[3];
+    forwards(3, s, u, D_, r_, 3, t, f, .4, a);
+    for (int i = 0; i < 3; ++i) {
+        double D0 = discount(s[i], 3, t, f, .4), D1 = discount(u[i], 3, t, f, .4);
+        assert(fabs(D_[i] - D1 / D0) < 1e-15);
+        assert(fabs(r_[i] - (D0 / D1 - 1) / a[i]) < 1e-14);
+    }
+    forwards(3, s, u, D_, nullptr, 3, t, f, .4);
+    assert(fabs(D_[2] - exp(-(.2 + .3 + .4 * .5))) < 1e-15);
+}
+
+
+void test_fms_par()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .01, .02, .03 };
+    double u[8], a[8];
+    for (int i = 0; i < 8; ++i) {
+        u[i] = .5 * (i + 1);
+        a[i] = .5;
+    }
+    size_t e[] = { 2, 4, 8 };
+    double rate[3], pv01[3];
+    par(0., 8, u, a, 3, e, rate, pv01, 3, t, f, .04);
+    for (int j = 0; j < 3; ++j) {
+        // fixed leg at the par rate plus unit notional at maturity is worth par
+        std::vector<double> c(a, a + e[j]);
+        for (auto& ci : c)
+            ci *= rate[j];
+        c.back() += 1;
+        assert(fabs(present_value(e[j], u, c.data(), 3, t, f, .04) - 1) < 1e-15);
+        std::vector<double> one(e[j], 1e-4 * .5);
+        assert(fabs(pv01[j] - present_value(e[j], u, one.data(), 3, t, f, .04)) < 1e-18);
+    }
+
+    par(1., 8, u, a, 1, e + 2, rate, nullptr, 3, t, f, .04);
+    double c[8];
+    for (int i = 0; i < 8; ++i)
+        c[i] = rate[0] * a[i] + (i == 7);
+    assert(fabs(present_value(8, u, c, 3, t, f, .04) - discount(1., 3, t, f, .04)) < 1e-15);
+
+    // start on the last knot
+    size_t e1 = 2;
+    par(3., 2, u + 6, a + 6, 1, &e1, rate, nullptr, 3, t, f, .04);
+    assert(fabs(rate[0] - (exp(.04 * .5) - 1) / .5) < 1e-14);
+}
+
+
+void test_fms_spread()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .01, .02, .03 };
+    portfolio<> pf;
+    double z[] = { .001, .01, -.005 };
+    double p[3], s[3] = { 0, 0, 0 };
+    for (int k = 0; k < 3; ++k) {
+        double u[] = { 1, 2, 3, 4 }, c[] = { .05, .05, .05, 1.05 };
+        size_t m = 2 + k;
+        c[m - 1] = 1.05;
+        pf.add(m, u, c);
+        double g[] = { f[0] + z[k], f[1] + z[k], f[2] + z[k] };
+        p[k] = present_value(m, u, c, 3, t, g, .03 + z[k]);
+    }
+    auto stats = spreads(pf, p, s, 3, t, f, .03);
+    assert(stats.converged == 3 && stats.max_steps < 10);
+    for (int k = 0; k < 3; ++k)
+        assert(fabs(s[k] - z[k]) < 1e-12);
+
+    s[0] = 0;
+    assert(spreads(pf, p, s, 3, t, f, .03, 1e-12, 1).converged == 2);
+    assert(isnan(s[0]));
+}
+
+
+void test_fms_yield()
+{
+    using namespace fms::pwflat;
+
+    double u[] = { .5, 1, 1.5, 2 }, c[] = { .03, .03, .03, 1.03 };
+    double y0 = .04, p = 0;
+    for (int i = 0; i < 4; ++i)
+        p += c[i] * exp(-y0 * u[i]);
+
+    double y = 0;
+    size_t n = yield(4, u, c, p, y);
+    assert(n < 10);
+    assert(fabs(y - y0) < 1e-12);
+
+    // far starting point
+    y = 10;
+    assert(yield(4, u, c, p, y) <= 100);
+    assert(fabs(y - y0) < 1e-12);
+
+    portfolio<> pf;
+    double ps[] = { p, 0 }, ys[] = { 0, 0 };
+    pf.add(4, u, c);
+    pf.add(2, u + 2, c + 2);
+    ps[1] = c[2] * exp(-.05 * u[2]) + c[3] * exp(-.05 * u[3]);
+    auto stats = yields(pf, ps, ys, 1e-12, 100, 2);
+    assert(stats.converged == 2);
+    assert(stats.max_steps < 10 && stats.steps >= stats.max_steps);
+    assert(fabs(ys[0] - y0) < 1e-12);
+    assert(fabs(ys[1] - .05) < 1e-12);
+}
+
+
+void test_fms_credit()
+{
+    using namespace fms::pwflat;
+
+    {
+        // constant rates
+        double r = .03, h = .02, P, A;
+        legs(5., P, A, 0, (double*)nullptr, (double*)nullptr, r, 0, (double*)nullptr, (double*)nullptr, h);
+        double A_ = (1 - exp(-(r + h) * 5)) / (r + h);
+        assert(fabs(A - A_) < 1e-14);
+        assert(fabs(P - h * A_) < 1e-14);
+    }
+    {
+        // zero total rate
+        double P, A;
+        legs(2., P, A, 0, (double*)nullptr, (double*)nullptr, -.01, 0, (double*)nullptr, (double*)nullptr, .01);
+        assert(fabs(A - 2) < 1e-15);
+        assert(fabs(P - .02) < 1e-15);
+    }
+    {
+        // compare with midpoint quadrature
+        double t[] = { 1, 2, 3 }, f[] = { .01, .02, .03 };
+        double s[] = { .5, 2, 4 }, h[] = { .01, .015, .02 };
+        double u[] = { 0, .5, 2.5, 6 }, P[4], A[4];
+        legs(4, u, P, A, 3, t, f, .04, 3, s, h, .025);
+        assert(P[0] == 0 && A[0] == 0);
+
+        size_t N = 100000;
+        double P_ = 0, A_ = 0, du = u[3] / N;
+        for (size_t i = 0; i < N; ++i) {
+            double v = (i + .5) * du;
+            double DS = discount(v, 3, t, f, .04) * discount(v, 3, s, h, .025);
+            A_ += DS * du;
+            P_ += value(v, 3, s, h, .025) * DS * du;
+        }
+        // midpoint error is O(du) at jumps of the hazard rate
+        assert(fabs(A[3] - A_) < 1e-8);
+        assert(fabs(P[3] - P_) < 1e-6);
+
+        double p, a;
+        legs(2.5, p, a, 3, t, f, .04, 3, s, h, .025);
+        assert(p == P[2] && a == A[2]);
+        legs(4, u, P, (double*)nullptr, 3, t, f, .04, 3, s, h, .025);
+        assert(P[2] == p);
+    }
+}
+
+
+void test_fms_composite()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .01, .02, .03 };
+    double s[] = { .5, 2, 4 }, g[] = { .001, .002, .003 };
+    curve<> base(3, t, f, .04), spread(3, s, g, .004);
+    composite<> c{ base.view(), spread.view() };
+    assert(c.curves() == 2);
+
+    double u[] = { 0, .25, .5, 1, 1.5, 2, 2.5, 3.5, 4, 5 };
+    for (double v : u) {
+        assert(c.value(v) == base.value(v) + spread.value(v));
+        assert(fabs(c.integral(v) - (base.integral(v) + spread.integral(v))) < 1e-15);
+        assert(fabs(c.discount(v) - base.discount(v) * spread.discount(v)) < 1e-15);
+    }
+
+    const auto& m = c.merged();
+    assert(m.size() == 5);
+    assert(m.time()[0] == .5 && m.time()[4] == 4);
+    assert(m.forward()[3] == .03 + .003);
+    assert(m.forward()[4] == .04 + .003);
+    assert(m.extrapolate() == .04 + .004);
+    assert(&c.merged() == &m);
+
+    double cf[] = { 1, 2, 3 };
+    double pv = c.present_value(3, u + 3, cf);
+    double pv_ = 0;
+    for (int i = 0; i < 3; ++i)
+        pv_ += cf[i] * base.discount(u[3 + i]) * spread.discount(u[3 + i]);
+    assert(fabs(pv - pv_) < 1e-14);
+}
+
+
+void test_fms_bump()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .01, .02, .03 };
+    curve<> c(3, t, f, .04);
+    double u[] = { .5, 1, 1.5, 2.5, 3, 4 }, cf[] = { 1, 2, 3, 4, 5, 6 };
+    double a = .0001;
+
+    {
+        shifted<> s{ c.view(), a };
+        double g[] = { f[0] + a, f[1] + a, f[2] + a };
+        curve<> c_(3, t, g, .04 + a);
+        for (double v : u) {
+            assert(s.value(v) == c_.value(v));
+            assert(fabs(s.discount(v) - c_.discount(v)) < 1e-15);
+        }
+        assert(fabs(s.present_value(6, u, cf) - c_.present_value(6, u, cf)) < 1e-13);
+    }
+    for (size_t j = 0; j <= 3; ++j) {
+        bumped<> b{ c.view(), j, a };
+        double g[] = { f[0], f[1], f[2], .04 };
+        g[j] += a;
+        curve<> c_(3, t, g, g[3]);
+        for (double v : u) {
+            assert(b.value(v) == c_.value(v));
+            assert(fabs(b.integral(v) - c_.integral(v)) < 1e-15);
+        }
+        assert(fabs(b.present_value(6, u, cf) - c_.present_value(6, u, cf)) < 1e-13);
+    }
+    {
+        twisted<> w{ c.view(), a, a, 2 };
+        assert(w.value(2) == c.value(2) + a);
+        assert(fabs(w.integral(2) - c.integral(2)) < 1e-15);
+        assert(fabs(w.integral(4) - (c.integral(4) + 4 * a + 4 * a * 4 / 2 - 2 * a * 4)) < 1e-15);
+    }
+    {
+        rolled<> r(c.view(), .5);
+        assert(r.value(0.5) == c.value(1));
+        assert(r.value(1) == c.value(1.5));
+        assert(r.discount(0) == 1);
+        for (double v : u)
+            assert(fabs(r.discount(v) - c.discount(v + .5) / c.discount(.5)) < 1e-15);
+        assert(isnan(r.value(-1)));
+    }
+}
+
+
+void test_fms_roll()
+{
+    using namespace fms::pwflat;
+
+    double t[] = { 1, 2, 3 }, f[] = { .01, .02, .03 };
+    curve<> c(3, t, f, .04);
+    portfolio<> pf;
+    double u[] = { .5, 1, 1.5, 2.5, 3.5 }, cf[] = { 1, 2, 3, 4, 5 };
+    pf.add(5, u, cf);
+    pf.add(2, u + 3, cf + 3);
+    pf.add(1, u, cf);
+
+    double s = 1. / 365;
+    auto r = roll(c.view(), s);
+    double th[3], paid[3];
+    double total = theta(pf, c.view(), s, th, paid, 2);
+    for (size_t k = 0; k < pf.size(); ++k) {
+        double us[5];
+        for (size_t i = 0; i < pf.size(k); ++i)
+            us[i] = pf.time(k)[i] - s;
+        double th_ = r.present_value(pf.size(k), us, pf.cash(k)) - pf.present_value(k, c.view());
+        assert(fabs(th[k] - th_) < 1e-14);
+        assert(paid[k] == 0);
+    }
+    assert(total == theta(pf, c.view(), s, nullptr, nullptr, 1));
+    assert(fabs(total - (th[0] + th[1] + th[2])) < 1e-14);
+
+    // cash paid at s is received, not lost
+    double th0 = theta(pf, c.view(), .5, th, paid);
+    assert(fabs(paid[2] - cf[0]) < 1e-15);
+    assert(fabs(th[2] - (cf[0] - cf[0] * c.discount(.5))) < 1e-15);
+    assert(th[2] > 0);
+    assert(th0 == th[0] + th[1] + th[2]);
+    for (size_t k = 0; k < pf.size(); ++k) {
+        double us[5], pv0 = pf.present_value(k, c.view()), ps = paid[k];
+        for (size_t i = 0; i < pf.size(k); ++i)
+            us[i] = pf.time(k)[i] - .5;
+        for (size_t i = 0; i < pf.size(k); ++i) {
+            if (us[i] > 0)
+                ps += pf.cash(k)[i] * roll(c.view(), .5).discount(us[i]);
+        }
+        assert(fabs(th[k] - (ps - pv0)) < 1e-14);
+    }
+}
+
 int main()
 {
     test_fms_pwflat<float>();
     test_fms_pwflat<double>();
+    test_fms_publish();
+    test_fms_shm();
+    test_fms_snapshot();
+    test_fms_store();
+    test_fms_family();
+    test_fms_scenario();
+    test_fms_shift();
+    test_fms_taylor();
+    test_fms_var();
+    test_fms_work_steal();
+    test_fms_sum();
+    test_fms_netting();
+    test_fms_csr();
+    test_fms_incremental();
+    test_fms_aggregate();
+    test_fms_grid();
+    test_fms_profile();
+    test_fms_forward();
+    test_fms_par();
+    test_fms_spread();
+    test_fms_yield();
+    test_fms_credit();
+    test_fms_composite();
+    test_fms_bump();
+    test_fms_roll();
 
     return 0;
 }
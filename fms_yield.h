@@ -0,0 +1,27 @@
+// fms_yield.h - Continuously compounded yield to maturity.
+// The yield y solves sum c exp(-y u) = p, the spread equation over a zero curve,
+// so it shares the safeguarded Newton solver with z-spreads.
+#pragma once
+#include "fms_spread.h"
+
+namespace fms::pwflat {
+
+    // Yield y of cash flows c at times u with price p starting from y.
+    // Return the number of steps taken or iter + 1 if not converged.
+    template<class T, class F>
+    inline size_t yield(size_t m, const T* u, const F* c, const F& p, F& y,
+        const F& tol = F(1e-12), size_t iter = 100) noexcept
+    {
+        return implied(m, u, c, p, y, tol, iter);
+    }
+
+    // yield y[k] of each instrument k with price p[k] starting from y[k]
+    template<class T, class F>
+    inline solve_stats yields(const portfolio<T, F>& pf, const F* p, F* y,
+        const F& tol = F(1e-12), size_t iter = 100, size_t p_ = 0)
+    {
+        // cash flows are contiguous
+        return implied(pf, pf.cash(0), p, y, tol, iter, p_);
+    }
+
+} // fms::pwflat